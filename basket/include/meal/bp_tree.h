@@ -0,0 +1,70 @@
+#ifndef MEAL_BASKET_BP_TREE_H
+#define MEAL_BASKET_BP_TREE_H
+
+#include "meal/def.h"
+#include "meal/alloc.h"
+#include "meal/iter.h"
+
+#include <stdbool.h>
+
+typedef struct bp_tree_t bp_tree_t;
+
+typedef struct bp_tree_iter_s {
+    void *node;
+    uint32_t index;
+    uint32_t typeSize;
+} bp_tree_iter_s;
+
+bp_tree_t *bp_tree_init_via(const alloc_t *alloc, cmp_f compare, uint32_t typeSize, uint32_t nodeSize);
+
+#define bp_tree_init(compare, typeSize, nodeSize) bp_tree_init_via(NULL, compare, typeSize, nodeSize)
+
+void bp_tree_term(bp_tree_t *tree);
+
+void *bp_tree_iter_tmp(bp_tree_t *tree, const void *ptr, bp_tree_iter_s *iter);
+
+void *bp_tree_begin_iter_tmp(bp_tree_t *tree, bp_tree_iter_s *iter);
+
+void *bp_tree_min_iter_tmp(bp_tree_t *tree, const void *ptr, bp_tree_iter_s *iter);
+
+void *bp_tree_max_iter_tmp(bp_tree_t *tree, const void *ptr, bp_tree_iter_s *iter);
+
+void *bp_tree_iter_tmp_next(bp_tree_iter_s *iter);
+
+void *bp_tree_iter_tmp_prev(bp_tree_iter_s *iter);
+
+void *bp_tree_iter_tmp_value(const bp_tree_iter_s *iter);
+
+void *bp_tree_insert(bp_tree_t *tree, const void *ptr);
+
+void *bp_tree_find(bp_tree_t *tree, const void *ptr);
+
+void *bp_tree_min(bp_tree_t *tree, const void *ptr);
+
+void *bp_tree_max(bp_tree_t *tree, const void *ptr);
+
+void bp_tree_foreach(bp_tree_t *tree, action_f func, void *data);
+
+iter_t *bp_tree_iter(bp_tree_t *tree);
+
+iter_t *bp_tree_find_iter(bp_tree_t *tree, const void *ptr);
+
+iter_t *bp_tree_min_iter(bp_tree_t *tree, const void *ptr);
+
+iter_t *bp_tree_max_iter(bp_tree_t *tree, const void *ptr);
+
+bool bp_tree_remove(bp_tree_t *tree, const void *ptr, void *dst);
+
+bool bp_tree_remove_min(bp_tree_t *tree, const void *ptr, void *dst);
+
+bool bp_tree_remove_max(bp_tree_t *tree, const void *ptr, void *dst);
+
+bool bp_tree_remove_iter(bp_tree_t *tree, iter_t *iter, void *dst);
+
+bool bp_tree_remove_iter_tmp(bp_tree_t *tree, bp_tree_iter_s *iter, void *dst);
+
+uint32_t bp_tree_size(bp_tree_t *tree);
+
+void bp_tree_clear(bp_tree_t *tree);
+
+#endif //MEAL_BASKET_BP_TREE_H
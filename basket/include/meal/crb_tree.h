@@ -0,0 +1,31 @@
+#ifndef MEAL_BASKET_CRB_TREE_H
+#define MEAL_BASKET_CRB_TREE_H
+
+#include "meal/def.h"
+#include "meal/alloc.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct crb_tree_t crb_tree_t;
+
+crb_tree_t *crb_tree_init_via(const alloc_t *alloc, cmp_f compare, uint32_t typeSize, uint32_t bufferSize);
+
+#define crb_tree_init(compare, typeSize, bufferSize) crb_tree_init_via(NULL, compare, typeSize, bufferSize)
+
+// No other thread may use the tree
+void crb_tree_term(crb_tree_t *tree);
+
+// Any thread, writers are serialized
+bool crb_tree_insert(crb_tree_t *tree, const void *ptr);
+
+// Any thread, writers are serialized
+bool crb_tree_remove(crb_tree_t *tree, const void *ptr, void *dst);
+
+// Any thread without locking, found element is copied to dst
+bool crb_tree_find(crb_tree_t *tree, const void *ptr, void *dst);
+
+// Any thread
+uint32_t crb_tree_size(crb_tree_t *tree);
+
+#endif //MEAL_BASKET_CRB_TREE_H
@@ -0,0 +1,39 @@
+#ifndef MEAL_BASKET_DEQUE_H
+#define MEAL_BASKET_DEQUE_H
+
+#include "meal/alloc.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct deque_t deque_t;
+
+deque_t *deque_init_via(const alloc_t *alloc, uint32_t typeSize, uint32_t bufferSize);
+
+#define deque_init(typeSize, bufferSize) deque_init_via(NULL, typeSize, bufferSize)
+
+void deque_term(deque_t *deque);
+
+void *deque_push_back(deque_t *deque, const void *ptr);
+
+void *deque_push_front(deque_t *deque, const void *ptr);
+
+bool deque_pop_back(deque_t *deque, void *dst);
+
+bool deque_pop_front(deque_t *deque, void *dst);
+
+void *deque_front(deque_t *deque);
+
+void *deque_back(deque_t *deque);
+
+void *deque_at(deque_t *deque, uint32_t index);
+
+uint32_t deque_size(deque_t *deque);
+
+uint32_t deque_type_size(deque_t *deque);
+
+uint32_t deque_buffer_size(deque_t *deque);
+
+void deque_clear(deque_t *deque);
+
+#endif // MEAL_BASKET_DEQUE_H
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "meal/alloc.h"
 
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef struct hash_stack_t hash_stack_t;
 
@@ -11,18 +12,34 @@ hash_stack_t *hash_stack_init_via(const alloc_t *alloc, uint32_t typeSize, uint3
 
 #define hash_stack_init(typeSize, bufferSize) hash_stack_init_via(NULL, typeSize, bufferSize)
 
+hash_stack_t *hash_stack_init_pow2_via(const alloc_t *alloc, uint32_t typeSize, uint32_t bufferSize);
+
+#define hash_stack_init_pow2(typeSize, bufferSize) hash_stack_init_pow2_via(NULL, typeSize, bufferSize)
+
 void hash_stack_term(hash_stack_t *stack);
 
 void *hash_stack_push(hash_stack_t *stack, const void *ptr);
 
+void *hash_stack_push_n(hash_stack_t *stack, const void *ptr, uint32_t count);
+
+void *hash_stack_push_uninit(hash_stack_t *stack);
+
+bool hash_stack_reserve(hash_stack_t *stack, uint32_t count);
+
 void hash_stack_pop_count(hash_stack_t *stack, uint32_t count);
 
 #define hash_stack_pop(stack) hash_stack_pop_count(stack, 1)
 
+bool hash_stack_pop_into_n(hash_stack_t *stack, void *dst, uint32_t count);
+
 void *hash_stack_peek_offset(hash_stack_t *stack, uint32_t index);
 
 #define hash_stack_peek(stack) hash_stack_peek_offset(stack, 1)
 
+void *hash_stack_at(hash_stack_t *stack, uint32_t index);
+
+void *hash_stack_span(hash_stack_t *stack, uint32_t index, uint32_t *count);
+
 uint32_t hash_stack_size(hash_stack_t *stack);
 
 uint32_t hash_stack_type_size(hash_stack_t *stack);
@@ -33,4 +50,97 @@ void hash_stack_clear(hash_stack_t *stack);
 
 void hash_stack_clear_hard(hash_stack_t *stack);
 
+void hash_stack_shrink(hash_stack_t *stack);
+
+void hash_stack_auto_shrink(hash_stack_t *stack, bool enable);
+
+/*Type-safe wrappers only: elements are copied by assignment of T, but slots are still found by the*/
+/*out-of-line hash_stack code with the typeSize stored at runtime*/
+#define HASH_STACK_DECLARE(name, T)\
+typedef struct name##_t name##_t;\
+\
+static inline name##_t *name##_init_via(const alloc_t *alloc, uint32_t bufferSize) {\
+    return (name##_t *)hash_stack_init_via(alloc, sizeof(T), bufferSize);\
+}\
+\
+static inline name##_t *name##_init(uint32_t bufferSize) {\
+    return (name##_t *)hash_stack_init_via(NULL, sizeof(T), bufferSize);\
+}\
+\
+static inline void name##_term(name##_t *stack) {\
+    hash_stack_term((hash_stack_t *)stack);\
+}\
+\
+static inline T *name##_push(name##_t *stack, T value) {\
+    T *dst = (T *)hash_stack_push_uninit((hash_stack_t *)stack);\
+    if (dst) {\
+        *dst = value;\
+    }\
+    return dst;\
+}\
+\
+static inline T *name##_push_n(name##_t *stack, const T *ptr, uint32_t count) {\
+    return (T *)hash_stack_push_n((hash_stack_t *)stack, ptr, count);\
+}\
+\
+static inline T *name##_push_uninit(name##_t *stack) {\
+    return (T *)hash_stack_push_uninit((hash_stack_t *)stack);\
+}\
+\
+static inline bool name##_reserve(name##_t *stack, uint32_t count) {\
+    return hash_stack_reserve((hash_stack_t *)stack, count);\
+}\
+\
+static inline void name##_pop_count(name##_t *stack, uint32_t count) {\
+    hash_stack_pop_count((hash_stack_t *)stack, count);\
+}\
+\
+static inline bool name##_pop(name##_t *stack, T *dst) {\
+    T *top = (T *)hash_stack_peek_offset((hash_stack_t *)stack, 1);\
+    if (!top) {\
+        return false;\
+    }\
+    if (dst) {\
+        *dst = *top;\
+    }\
+    hash_stack_pop_count((hash_stack_t *)stack, 1);\
+    return true;\
+}\
+\
+static inline bool name##_pop_into_n(name##_t *stack, T *dst, uint32_t count) {\
+    return hash_stack_pop_into_n((hash_stack_t *)stack, dst, count);\
+}\
+\
+static inline T *name##_peek_offset(name##_t *stack, uint32_t index) {\
+    return (T *)hash_stack_peek_offset((hash_stack_t *)stack, index);\
+}\
+\
+static inline T *name##_peek(name##_t *stack) {\
+    return (T *)hash_stack_peek_offset((hash_stack_t *)stack, 1);\
+}\
+\
+static inline T *name##_at(name##_t *stack, uint32_t index) {\
+    return (T *)hash_stack_at((hash_stack_t *)stack, index);\
+}\
+\
+static inline T *name##_span(name##_t *stack, uint32_t index, uint32_t *count) {\
+    return (T *)hash_stack_span((hash_stack_t *)stack, index, count);\
+}\
+\
+static inline uint32_t name##_size(name##_t *stack) {\
+    return hash_stack_size((hash_stack_t *)stack);\
+}\
+\
+static inline void name##_clear(name##_t *stack) {\
+    hash_stack_clear((hash_stack_t *)stack);\
+}\
+\
+static inline void name##_clear_hard(name##_t *stack) {\
+    hash_stack_clear_hard((hash_stack_t *)stack);\
+}\
+\
+static inline void name##_shrink(name##_t *stack) {\
+    hash_stack_shrink((hash_stack_t *)stack);\
+}
+
 #endif // MEAL_BASKET_HASH_STACK_H
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef MEAL_BASKET_PRB_TREE_H
+#define MEAL_BASKET_PRB_TREE_H
+
+#include "meal/def.h"
+#include "meal/alloc.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct prb_tree_t prb_tree_t;
+
+typedef struct prb_snapshot_t prb_snapshot_t;
+
+prb_tree_t *prb_tree_init_via(const alloc_t *alloc, cmp_f compare, uint32_t typeSize, uint32_t bufferSize);
+
+#define prb_tree_init(compare, typeSize, bufferSize) prb_tree_init_via(NULL, compare, typeSize, bufferSize)
+
+// Writer thread only, every snapshot must be released before
+void prb_tree_term(prb_tree_t *tree);
+
+// Writer thread only, NULL when the key is already present, as rb_tree_insert
+const void *prb_tree_insert(prb_tree_t *tree, const void *ptr);
+
+// Writer thread only
+const void *prb_tree_find(prb_tree_t *tree, const void *ptr);
+
+// Writer thread only
+bool prb_tree_remove(prb_tree_t *tree, const void *ptr, void *dst);
+
+// Writer thread only
+void prb_tree_foreach(prb_tree_t *tree, const_action_f func, void *data);
+
+// Writer thread only
+uint32_t prb_tree_size(prb_tree_t *tree);
+
+// Writer thread only, O(1): the snapshot shares every node with the tree
+prb_snapshot_t *prb_tree_snapshot(prb_tree_t *tree);
+
+// Any thread
+const void *prb_snapshot_find(prb_snapshot_t *snapshot, const void *ptr);
+
+// Any thread
+const void *prb_snapshot_min(prb_snapshot_t *snapshot, const void *ptr);
+
+// Any thread
+const void *prb_snapshot_max(prb_snapshot_t *snapshot, const void *ptr);
+
+// Any thread
+void prb_snapshot_foreach(prb_snapshot_t *snapshot, const_action_f func, void *data);
+
+// Any thread
+uint32_t prb_snapshot_size(prb_snapshot_t *snapshot);
+
+// Any thread, nodes are reclaimed by the writer on its next update
+void prb_snapshot_release(prb_snapshot_t *snapshot);
+
+#endif //MEAL_BASKET_PRB_TREE_H
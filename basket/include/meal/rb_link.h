@@ -0,0 +1,207 @@
+#ifndef MEAL_BASKET_RB_LINK_H
+#define MEAL_BASKET_RB_LINK_H
+
+#include "meal/alloc.h"
+#include "meal/list_pool.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+typedef struct rb_link_t rb_link_t;
+
+typedef struct rb_link_t {
+    uintptr_t parentColor;
+    rb_link_t *left;
+    rb_link_t *right;
+} rb_link_t;
+
+void rb_link_insert(rb_link_t **root, rb_link_t *node, rb_link_t *parent, rb_link_t **slot);
+
+void rb_link_erase(rb_link_t **root, rb_link_t *node);
+
+rb_link_t *rb_link_first(rb_link_t *root);
+
+rb_link_t *rb_link_last(rb_link_t *root);
+
+rb_link_t *rb_link_next(rb_link_t *node);
+
+rb_link_t *rb_link_prev(rb_link_t *node);
+
+// O(n) red-black invariant check, for tests and debugging
+bool rb_link_check(rb_link_t *root);
+
+#define RB_TREE_CMP_NUM(a, b) (((b) < (a)) - ((a) < (b)))
+
+#define RB_TREE_CMP_PTR(a, b) RB_TREE_CMP_NUM((uintptr_t)(a), (uintptr_t)(b))
+
+#define RB_TREE_CMP_STR(a, b) strcmp(a, b)
+
+/*Tree with keys stored inline and CMP(KeyT a, KeyT b) expanded in place of the cmp_f call*/
+/*Lookups are specialised, balancing and node allocation stay shared out-of-line code*/
+#define RB_TREE_DECLARE(name, KeyT, ValT, CMP)\
+typedef struct name##_entry_t {\
+    rb_link_t link;\
+    KeyT key;\
+    ValT value;\
+} name##_entry_t;\
+\
+typedef struct name##_t {\
+    const alloc_t *alloc;\
+    list_pool_t *pool;\
+    rb_link_t *root;\
+    uint32_t size;\
+} name##_t;\
+\
+static inline name##_t *name##_init_via(const alloc_t *alloc, uint32_t bufferSize) {\
+    name##_t *tree = (name##_t *)alloc_malloc(alloc, sizeof(name##_t));\
+    if (!tree) {\
+        return NULL;\
+    }\
+    tree->pool = list_pool_init_via(alloc, sizeof(name##_entry_t), bufferSize);\
+    if (!tree->pool) {\
+        alloc_free(alloc, tree);\
+        return NULL;\
+    }\
+    tree->alloc = alloc;\
+    tree->root = NULL;\
+    tree->size = 0;\
+    return tree;\
+}\
+\
+static inline name##_t *name##_init(uint32_t bufferSize) {\
+    return name##_init_via(NULL, bufferSize);\
+}\
+\
+static inline void name##_term(name##_t *tree) {\
+    list_pool_term(tree->pool);\
+    alloc_free(tree->alloc, tree);\
+}\
+\
+static inline name##_entry_t *name##_insert(name##_t *tree, KeyT key, ValT value) {\
+    rb_link_t *parent = NULL;\
+    rb_link_t **slot = &tree->root;\
+    while (*slot) {\
+        parent = *slot;\
+        const int32_t cmpr = CMP(key, ((name##_entry_t *)parent)->key);\
+        if (cmpr < 0) {\
+            slot = &parent->left;\
+        } else if (cmpr > 0) {\
+            slot = &parent->right;\
+        } else {\
+            return NULL;\
+        }\
+    }\
+    name##_entry_t *entry = (name##_entry_t *)list_pool_get(tree->pool);\
+    if (!entry) {\
+        return NULL;\
+    }\
+    entry->key = key;\
+    entry->value = value;\
+    rb_link_insert(&tree->root, &entry->link, parent, slot);\
+    tree->size++;\
+    return entry;\
+}\
+\
+static inline name##_entry_t *name##_find(name##_t *tree, KeyT key) {\
+    rb_link_t *tmp = tree->root;\
+    while (tmp) {\
+        const int32_t cmpr = CMP(key, ((name##_entry_t *)tmp)->key);\
+        if (cmpr < 0) {\
+            tmp = tmp->left;\
+        } else if (cmpr > 0) {\
+            tmp = tmp->right;\
+        } else {\
+            break;\
+        }\
+    }\
+    return (name##_entry_t *)tmp;\
+}\
+\
+static inline name##_entry_t *name##_min(name##_t *tree, KeyT key) {\
+    rb_link_t *tmp = tree->root;\
+    rb_link_t *result = NULL;\
+    while (tmp) {\
+        const int32_t cmpr = CMP(key, ((name##_entry_t *)tmp)->key);\
+        if (cmpr < 0) {\
+            result = tmp;\
+            tmp = tmp->left;\
+        } else if (cmpr > 0) {\
+            tmp = tmp->right;\
+        } else {\
+            return (name##_entry_t *)tmp;\
+        }\
+    }\
+    return (name##_entry_t *)result;\
+}\
+\
+static inline name##_entry_t *name##_max(name##_t *tree, KeyT key) {\
+    rb_link_t *tmp = tree->root;\
+    rb_link_t *result = NULL;\
+    while (tmp) {\
+        const int32_t cmpr = CMP(key, ((name##_entry_t *)tmp)->key);\
+        if (cmpr < 0) {\
+            tmp = tmp->left;\
+        } else if (cmpr > 0) {\
+            result = tmp;\
+            tmp = tmp->right;\
+        } else {\
+            return (name##_entry_t *)tmp;\
+        }\
+    }\
+    return (name##_entry_t *)result;\
+}\
+\
+static inline name##_entry_t *name##_first(name##_t *tree) {\
+    return (name##_entry_t *)rb_link_first(tree->root);\
+}\
+\
+static inline name##_entry_t *name##_last(name##_t *tree) {\
+    return (name##_entry_t *)rb_link_last(tree->root);\
+}\
+\
+static inline name##_entry_t *name##_next(name##_entry_t *entry) {\
+    return (name##_entry_t *)rb_link_next(&entry->link);\
+}\
+\
+static inline name##_entry_t *name##_prev(name##_entry_t *entry) {\
+    return (name##_entry_t *)rb_link_prev(&entry->link);\
+}\
+\
+static inline void name##_remove_entry(name##_t *tree, name##_entry_t *entry) {\
+    rb_link_erase(&tree->root, &entry->link);\
+    list_pool_free(tree->pool, entry);\
+    tree->size--;\
+}\
+\
+static inline bool name##_remove(name##_t *tree, KeyT key, ValT *dst) {\
+    name##_entry_t *entry = name##_find(tree, key);\
+    if (!entry) {\
+        return false;\
+    }\
+    if (dst) {\
+        *dst = entry->value;\
+    }\
+    name##_remove_entry(tree, entry);\
+    return true;\
+}\
+\
+static inline uint32_t name##_size(name##_t *tree) {\
+    return tree->size;\
+}\
+\
+static inline void name##_clear(name##_t *tree) {\
+    list_pool_reset(tree->pool, true);\
+    tree->root = NULL;\
+    tree->size = 0;\
+}
+
+RB_TREE_DECLARE(rb_u32_tree, uint32_t, void *, RB_TREE_CMP_NUM)
+
+RB_TREE_DECLARE(rb_u64_tree, uint64_t, void *, RB_TREE_CMP_NUM)
+
+RB_TREE_DECLARE(rb_ptr_tree, const void *, void *, RB_TREE_CMP_PTR)
+
+RB_TREE_DECLARE(rb_str_tree, const char *, void *, RB_TREE_CMP_STR)
+
+#endif //MEAL_BASKET_RB_LINK_H
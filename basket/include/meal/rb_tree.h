@@ -9,26 +9,72 @@
 
 typedef struct rb_tree_t rb_tree_t;
 
+typedef struct rb_tree_iter_s {
+    void *node;
+} rb_tree_iter_s;
+
 rb_tree_t *rb_tree_init_via(const alloc_t *alloc, cmp_f compare, uint32_t typeSize, uint32_t bufferSize);
 
 #define rb_tree_init(compare, typeSize, bufferSize) rb_tree_init_via(NULL, compare, typeSize, bufferSize)
 
+rb_tree_t *rb_tree_init_ranked_via(const alloc_t *alloc, cmp_f compare, uint32_t typeSize, uint32_t bufferSize);
+
+#define rb_tree_init_ranked(compare, typeSize, bufferSize) rb_tree_init_ranked_via(NULL, compare, typeSize, bufferSize)
+
+rb_tree_t *rb_tree_init_sibling(rb_tree_t *tree);
+
 void rb_tree_term(rb_tree_t *tree);
 
-iter_t *rb_tree_iter_tmp(rb_tree_t *tree, const void *ptr);
+void *rb_tree_iter_tmp(rb_tree_t *tree, const void *ptr, rb_tree_iter_s *iter);
+
+void *rb_tree_begin_iter_tmp(rb_tree_t *tree, rb_tree_iter_s *iter);
+
+void *rb_tree_min_iter_tmp(rb_tree_t *tree, const void *ptr, rb_tree_iter_s *iter);
+
+void *rb_tree_max_iter_tmp(rb_tree_t *tree, const void *ptr, rb_tree_iter_s *iter);
+
+void *rb_tree_iter_tmp_next(rb_tree_iter_s *iter);
+
+void *rb_tree_iter_tmp_prev(rb_tree_iter_s *iter);
+
+void *rb_tree_iter_tmp_value(const rb_tree_iter_s *iter);
 
 void *rb_tree_insert(rb_tree_t *tree, const void *ptr);
 
 iter_t *rb_tree_insert_iter(rb_tree_t *tree, const void *ptr);
 
+void *rb_tree_insert_hint(rb_tree_t *tree, rb_tree_iter_s *hint, const void *ptr);
+
+bool rb_tree_build_sorted(rb_tree_t *tree, const void *array, uint32_t count);
+
 void *rb_tree_find(rb_tree_t *tree, const void *ptr);
 
+uint32_t rb_tree_find_batch(rb_tree_t *tree, const void *keys, uint32_t count, void **out);
+
 void *rb_tree_min(rb_tree_t *tree, const void *ptr);
 
 void *rb_tree_max(rb_tree_t *tree, const void *ptr);
 
+void *rb_tree_find_near(rb_tree_t *tree, rb_tree_iter_s *iter, const void *ptr);
+
+void *rb_tree_select(rb_tree_t *tree, uint32_t index);
+
+uint32_t rb_tree_rank(rb_tree_t *tree, const void *ptr);
+
+// Half-open: min <= key < max
+uint32_t rb_tree_count_range(rb_tree_t *tree, const void *min, const void *max);
+
 void rb_tree_foreach(rb_tree_t *tree, action_f func, void *data);
 
+// Half-open: min <= key < max
+void rb_tree_foreach_range(rb_tree_t *tree, const void *min, const void *max, action_f func, void *data);
+
+void rb_tree_parallel_foreach(rb_tree_t *tree, uint32_t threads, action_f func, void *data);
+
+// identity seeds every chunk (0 for a sum), acc holds the initial value and receives the result
+bool rb_tree_parallel_reduce(rb_tree_t *tree, uint32_t threads, reduce_f reduce, combine_f combine,
+                             const void *identity, void *acc, uint32_t accSize, void *data);
+
 iter_t *rb_tree_iter(rb_tree_t *tree);
 
 iter_t *rb_tree_find_iter(rb_tree_t *tree, const void *ptr);
@@ -45,8 +91,28 @@ bool rb_tree_remove_max(rb_tree_t *tree, const void *ptr, void *dst);
 
 bool rb_tree_remove_iter(rb_tree_t *tree, iter_t *iter, void *dst);
 
+bool rb_tree_remove_iter_tmp(rb_tree_t *tree, rb_tree_iter_s *iter, void *dst);
+
+// Half-open: min <= key < max
+uint32_t rb_tree_remove_range(rb_tree_t *tree, const void *min, const void *max);
+
+// O(log n) on ranked trees, plain ones also count the smaller half: O(log n + min(k, n - k))
+bool rb_tree_split(rb_tree_t *tree, const void *ptr, rb_tree_t *right);
+
+bool rb_tree_join(rb_tree_t *left, rb_tree_t *right);
+
+uint32_t rb_tree_merge(rb_tree_t *tree, rb_tree_t *other);
+
+// Refuses while siblings or a crb_tree still share the node pool
+bool rb_tree_compact(rb_tree_t *tree);
+
 uint32_t rb_tree_size(rb_tree_t *tree);
 
+// O(n) red-black and ordering invariant check, for tests and debugging
+bool rb_tree_check(rb_tree_t *tree);
+
+void rb_tree_reset(rb_tree_t *tree, bool keepBlocks);
+
 void rb_tree_clear(rb_tree_t *tree);
 
 #endif //MEAL_BASKET_RB_TREE_H
\ No newline at end of file
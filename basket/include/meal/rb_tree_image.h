@@ -0,0 +1,44 @@
+#ifndef MEAL_BASKET_RB_TREE_IMAGE_H
+#define MEAL_BASKET_RB_TREE_IMAGE_H
+
+#include "meal/def.h"
+#include "meal/alloc.h"
+#include "meal/print.h"
+#include "meal/rb_tree.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct rb_tree_image_t rb_tree_image_t;
+
+bool rb_tree_save(rb_tree_t *tree, writer_f writer, void *data);
+
+bool rb_tree_save_file(rb_tree_t *tree, const char *path);
+
+// O(1): header, typeSize and file length are checked, element order is trusted so no page is touched;
+// images from untrusted sources go through rb_tree_image_verify before lookups
+rb_tree_image_t *rb_tree_load_mapped_via(const alloc_t *alloc, const char *path, cmp_f compare, uint32_t typeSize);
+
+#define rb_tree_load_mapped(path, compare, typeSize) rb_tree_load_mapped_via(NULL, path, compare, typeSize)
+
+// O(n) check that elements are strictly ascending, lookups on an unsorted image give wrong answers
+bool rb_tree_image_verify(rb_tree_image_t *image);
+
+// Always verifies order, the image is rejected unless it's strictly ascending
+bool rb_tree_load(rb_tree_t *tree, const char *path);
+
+void rb_tree_image_term(rb_tree_image_t *image);
+
+const void *rb_tree_image_find(rb_tree_image_t *image, const void *ptr);
+
+const void *rb_tree_image_min(rb_tree_image_t *image, const void *ptr);
+
+const void *rb_tree_image_max(rb_tree_image_t *image, const void *ptr);
+
+const void *rb_tree_image_at(rb_tree_image_t *image, uint32_t index);
+
+const void *rb_tree_image_data(rb_tree_image_t *image);
+
+uint32_t rb_tree_image_size(rb_tree_image_t *image);
+
+#endif //MEAL_BASKET_RB_TREE_IMAGE_H
@@ -0,0 +1,39 @@
+#ifndef MEAL_BASKET_STATIC_INDEX_H
+#define MEAL_BASKET_STATIC_INDEX_H
+
+#include "meal/def.h"
+#include "meal/alloc.h"
+#include "meal/rb_tree.h"
+
+#include <stdint.h>
+
+typedef struct static_index_t static_index_t;
+
+typedef struct static_index_iter_s {
+    static_index_t *index;
+    uint32_t pos;
+} static_index_iter_s;
+
+static_index_t *static_index_init_via(const alloc_t *alloc, rb_tree_t *tree);
+
+#define static_index_init(tree) static_index_init_via(NULL, tree)
+
+void static_index_term(static_index_t *index);
+
+const void *static_index_find(static_index_t *index, const void *ptr);
+
+const void *static_index_min(static_index_t *index, const void *ptr);
+
+const void *static_index_max(static_index_t *index, const void *ptr);
+
+const void *static_index_begin_iter_tmp(static_index_t *index, static_index_iter_s *iter);
+
+const void *static_index_min_iter_tmp(static_index_t *index, const void *ptr, static_index_iter_s *iter);
+
+const void *static_index_iter_tmp_next(static_index_iter_s *iter);
+
+void static_index_foreach(static_index_t *index, const_action_f func, void *data);
+
+uint32_t static_index_size(static_index_t *index);
+
+#endif //MEAL_BASKET_STATIC_INDEX_H
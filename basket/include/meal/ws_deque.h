@@ -0,0 +1,28 @@
+#ifndef MEAL_BASKET_WS_DEQUE_H
+#define MEAL_BASKET_WS_DEQUE_H
+
+#include "meal/alloc.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct ws_deque_t ws_deque_t;
+
+ws_deque_t *ws_deque_init_via(const alloc_t *alloc, uint32_t bufferSize);
+
+#define ws_deque_init(bufferSize) ws_deque_init_via(NULL, bufferSize)
+
+void ws_deque_term(ws_deque_t *deque);
+
+// Owner thread only
+bool ws_deque_push(ws_deque_t *deque, void *task);
+
+// Owner thread only
+void *ws_deque_pop(ws_deque_t *deque);
+
+// Any thread, NULL if deque is empty or other thread took the task first
+void *ws_deque_steal(ws_deque_t *deque);
+
+uint32_t ws_deque_size(ws_deque_t *deque);
+
+#endif // MEAL_BASKET_WS_DEQUE_H
\ No newline at end of file
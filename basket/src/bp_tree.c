@@ -0,0 +1,905 @@
+#include "meal/bp_tree.h"
+
+#include "meal/list_pool.h"
+#include "meal/assert.h"
+#include "meal/memory.h"
+#include "iter.h"
+
+#define TAG "BP Tree"
+
+#define CACHE_LINE 64
+
+#define ITER_BUFFER_SIZE 16
+
+typedef struct node_t node_t;
+
+/*Inner nodes keep count keys and count + 1 children, children go first,*/
+/*key i is the smallest element of child i + 1 at the time it was split off.*/
+/*Leaves are level 0, keep elements only and are linked both ways for scans*/
+typedef struct node_t {
+    node_t *prev;
+    node_t *next;
+    uint32_t count;
+    uint32_t level;
+    void_t data;
+} node_t;
+
+#define IS_LEAF(node) (!(node)->level)
+
+#define NODE(ptr) ((node_t *)ptr)
+
+typedef struct bp_tree_t {
+    const alloc_t *alloc;
+    cmp_f compare;
+    list_pool_t *iterPool;
+    node_t *root;
+    void *buffer;
+    uint32_t typeSize;
+    uint32_t nodeSize;
+    uint32_t leafCap;
+    uint32_t innerCap;
+    uint32_t size;
+} bp_tree_t;
+
+typedef struct iter_box_t {
+    list_pool_t *pool;
+    node_t *node;
+    uint32_t index;
+    uint32_t typeSize;
+} iter_box_t;
+
+/*Box lives in pool memory right after the iter_t header*/
+#define ITER(iter) ((iter_box_t *)((void *)(iter) + sizeof(iter_t)))
+
+/*Node payload is raw malloc memory, addressed from the node so no lvalue of void_t is punned*/
+#define DATA(node) ((void *)(node) + sizeof(node_t))
+
+#define CHILDREN(node) ((node_t **)DATA(node))
+
+#define LEAF_KEY(tree, node, index) (DATA(node) + (index) * (tree)->typeSize)
+
+#define INNER_KEY(tree, node, index)\
+(DATA(node) + sizeof(node_t *) * ((tree)->innerCap + 1) + (index) * (tree)->typeSize)
+
+#define KEY(tree, node, index) (IS_LEAF(node) ? LEAF_KEY(tree, node, index) : INNER_KEY(tree, node, index))
+
+#define MIN_COUNT(tree, node) (IS_LEAF(node) ? (tree)->leafCap / 2 : ((tree)->innerCap - 1) / 2)
+
+#define IS_FULL(tree, node) ((node)->count == (IS_LEAF(node) ? (tree)->leafCap : (tree)->innerCap))
+
+bp_tree_t *bp_tree_init_via(const alloc_t *alloc, cmp_f compare, uint32_t typeSize, uint32_t nodeSize) {
+    ASSERT_ERROR(compare, TAG, "NULL comparator") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(typeSize, TAG, "TypeSize must be more than 0: typeSize = %d", typeSize) {
+        return NULL;
+    }
+
+    /*Node size is rounded up to whole cache lines*/
+    nodeSize = (nodeSize + (CACHE_LINE - 1)) & ~(CACHE_LINE - 1);
+
+    const uint32_t leafCap = (nodeSize - sizeof(node_t)) / typeSize;
+    const uint32_t innerCap = (nodeSize - sizeof(node_t) - sizeof(node_t *)) / (typeSize + sizeof(node_t *));
+
+    ASSERT_ERROR(nodeSize > sizeof(node_t) + sizeof(node_t *) && leafCap >= 3 && innerCap >= 3, TAG,
+                 "NodeSize must fit at least 3 elements: typeSize = %d; nodeSize = %d", typeSize, nodeSize) {
+        return NULL;
+    }
+
+    bp_tree_t *tree = alloc_malloc(alloc, sizeof(bp_tree_t));
+
+    ASSERT_ERROR(tree, TAG, "Can't allocate memory for tree") {
+        return NULL;
+    }
+
+    tree->buffer = alloc_malloc(alloc, typeSize);
+
+    ASSERT_ERROR(tree->buffer, TAG, "Can't allocate memory for tree buffer") {
+        alloc_free(alloc, tree);
+        return NULL;
+    }
+
+    tree->iterPool = list_pool_init_via(alloc, sizeof(iter_t) + sizeof(iter_box_t), ITER_BUFFER_SIZE);
+
+    ASSERT_ERROR(tree->iterPool, TAG, "Can't allocate memory for pool") {
+        alloc_free(alloc, tree->buffer);
+        alloc_free(alloc, tree);
+        return NULL;
+    }
+
+    tree->alloc = alloc;
+    tree->compare = compare;
+    tree->root = NULL;
+    tree->typeSize = typeSize;
+    tree->nodeSize = nodeSize;
+    tree->leafCap = leafCap;
+    tree->innerCap = innerCap;
+    tree->size = 0;
+
+    return tree;
+}
+
+void bp_tree_term(bp_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return;
+    }
+
+    bp_tree_clear(tree);
+
+    list_pool_term(tree->iterPool);
+    alloc_free(tree->alloc, tree->buffer);
+    alloc_free(tree->alloc, tree);
+}
+
+static node_t *_bp_tree_node_new(bp_tree_t *tree, uint32_t level) {
+    node_t *node = alloc_malloc(tree->alloc, tree->nodeSize);
+
+    ASSERT_ERROR(node, TAG, "Can't allocate memory for tree node") {
+        return NULL;
+    }
+
+    node->prev = NULL;
+    node->next = NULL;
+    node->count = 0;
+    node->level = level;
+
+    return node;
+}
+
+static void _bp_tree_free_nodes(bp_tree_t *tree, node_t *node) {
+    if (!IS_LEAF(node)) {
+        for (uint32_t i = 0; i <= node->count; i++) {
+            _bp_tree_free_nodes(tree, CHILDREN(node)[i]);
+        }
+    }
+
+    alloc_free(tree->alloc, node);
+}
+
+/*Keys in node are contiguous, so binary search stays in a few cache lines*/
+static uint32_t _bp_tree_lower(bp_tree_t *tree, node_t *node, const void *ptr, bool *equal) {
+    const void *keys = KEY(tree, node, 0);
+
+    uint32_t begin = 0;
+    uint32_t end = node->count;
+    *equal = false;
+
+    while (begin < end) {
+        const uint32_t middle = begin + (end - begin) / 2;
+        const int32_t cmpr = tree->compare(ptr, keys + middle * tree->typeSize);
+
+        if (cmpr > 0) {
+            begin = middle + 1;
+        } else {
+            *equal = !cmpr;
+            end = middle;
+        }
+    }
+
+    return begin;
+}
+
+static uint32_t _bp_tree_child(bp_tree_t *tree, node_t *node, const void *ptr) {
+    bool equal;
+    const uint32_t index = _bp_tree_lower(tree, node, ptr, &equal);
+    return index + equal;
+}
+
+static node_t *_bp_tree_leaf(bp_tree_t *tree, const void *ptr) {
+    node_t *node = tree->root;
+    while (node && !IS_LEAF(node)) {
+        node = CHILDREN(node)[_bp_tree_child(tree, node, ptr)];
+    }
+    return node;
+}
+
+#define EQUAL 0
+#define LOWER 1
+#define UPPER 2
+
+/*Fills leaf position: EQUAL is exact match, LOWER is first element not less than ptr,*/
+/*UPPER is last element not greater than ptr*/
+static bool _bp_tree_locate(bp_tree_t *tree, const void *ptr, uint32_t mode, node_t **result, uint32_t *index) {
+    node_t *node = _bp_tree_leaf(tree, ptr);
+    if (!node) {
+        return false;
+    }
+
+    bool equal;
+    uint32_t i = _bp_tree_lower(tree, node, ptr, &equal);
+
+    if (!equal) {
+        if (mode == EQUAL) {
+            return false;
+        } else if (mode == LOWER) {
+            if (i == node->count) {
+                node = node->next;
+                i = 0;
+            }
+        } else {
+            if (!i) {
+                node = node->prev;
+                i = node ? node->count : 0;
+            }
+            i--;
+        }
+    }
+
+    if (!node) {
+        return false;
+    }
+
+    *result = node;
+    *index = i;
+    return true;
+}
+
+#define NEXT(node, index)\
+do {\
+    if (++index == node->count) {\
+        node = node->next;\
+        index = 0;\
+    }\
+} while (0)
+
+#define PREV(node, index)\
+do {\
+    if (!index) {\
+        node = node->prev;\
+        index = node ? node->count : 0;\
+    }\
+    index--;\
+} while (0)
+
+static void _bp_tree_iter_next(iter_t *iter) {
+    if (ITER(iter)->node) {
+        NEXT(ITER(iter)->node, ITER(iter)->index);
+    }
+}
+
+static void _bp_tree_iter_prev(iter_t *iter) {
+    if (ITER(iter)->node) {
+        PREV(ITER(iter)->node, ITER(iter)->index);
+    }
+}
+
+static void *_bp_tree_iter_value(iter_t *iter) {
+    iter_box_t *box = ITER(iter);
+    return box->node ? (void *)&box->node->data + box->index * box->typeSize : NULL;
+}
+
+static iter_t *_bp_tree_iter_copy(iter_t *iter);
+
+static void _bp_tree_iter_term(iter_t *iter) {
+    list_pool_free(ITER(iter)->pool, iter);
+}
+
+static const iter_funcs_t _iter_funcs = {
+        _bp_tree_iter_next,
+        _bp_tree_iter_prev,
+        _bp_tree_iter_value,
+        _bp_tree_iter_copy,
+        _bp_tree_iter_term
+};
+
+#define CREATE_ITER(iter, _pool, _node, _index, _typeSize)\
+do {\
+    iter = list_pool_get(_pool);\
+    ASSERT_ERROR(iter, TAG, "Can't allocate memory for tree iterator") {\
+        return NULL;\
+    }\
+    iter->funcs = &_iter_funcs;\
+    ITER(iter)->pool = _pool;\
+    ITER(iter)->node = _node;\
+    ITER(iter)->index = _index;\
+    ITER(iter)->typeSize = _typeSize;\
+} while (0)
+
+static iter_t *_bp_tree_iter_copy(iter_t *iter) {
+    iter_box_t *box = ITER(iter);
+
+    iter_t *newIter;
+    CREATE_ITER(newIter, box->pool, box->node, box->index, box->typeSize);
+    return newIter;
+}
+
+#define ITER_TMP_VALUE(iter) ((iter)->node ? (void *)&NODE((iter)->node)->data + (iter)->index * (iter)->typeSize : NULL)
+
+static void *_bp_tree_locate_tmp(bp_tree_t *tree, const void *ptr, uint32_t mode, bp_tree_iter_s *iter) {
+    node_t *node;
+    uint32_t index;
+
+    iter->typeSize = tree->typeSize;
+    if (_bp_tree_locate(tree, ptr, mode, &node, &index)) {
+        iter->node = node;
+        iter->index = index;
+    } else {
+        iter->node = NULL;
+        iter->index = 0;
+    }
+
+    return ITER_TMP_VALUE(iter);
+}
+
+void *bp_tree_iter_tmp(bp_tree_t *tree, const void *ptr, bp_tree_iter_s *iter) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    return _bp_tree_locate_tmp(tree, ptr, EQUAL, iter);
+}
+
+static node_t *_bp_tree_first_leaf(bp_tree_t *tree) {
+    node_t *node = tree->root;
+    while (node && !IS_LEAF(node)) {
+        node = CHILDREN(node)[0];
+    }
+    return node;
+}
+
+void *bp_tree_begin_iter_tmp(bp_tree_t *tree, bp_tree_iter_s *iter) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    iter->node = _bp_tree_first_leaf(tree);
+    iter->index = 0;
+    iter->typeSize = tree->typeSize;
+
+    return ITER_TMP_VALUE(iter);
+}
+
+void *bp_tree_min_iter_tmp(bp_tree_t *tree, const void *ptr, bp_tree_iter_s *iter) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    return _bp_tree_locate_tmp(tree, ptr, LOWER, iter);
+}
+
+void *bp_tree_max_iter_tmp(bp_tree_t *tree, const void *ptr, bp_tree_iter_s *iter) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    return _bp_tree_locate_tmp(tree, ptr, UPPER, iter);
+}
+
+void *bp_tree_iter_tmp_next(bp_tree_iter_s *iter) {
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    if (iter->node) {
+        node_t *node = iter->node;
+        NEXT(node, iter->index);
+        iter->node = node;
+    }
+
+    return ITER_TMP_VALUE(iter);
+}
+
+void *bp_tree_iter_tmp_prev(bp_tree_iter_s *iter) {
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    if (iter->node) {
+        node_t *node = iter->node;
+        PREV(node, iter->index);
+        iter->node = node;
+    }
+
+    return ITER_TMP_VALUE(iter);
+}
+
+void *bp_tree_iter_tmp_value(const bp_tree_iter_s *iter) {
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    return ITER_TMP_VALUE(iter);
+}
+
+/*Splits full child of not full parent in halves*/
+static bool _bp_tree_split(bp_tree_t *tree, node_t *parent, uint32_t index) {
+    node_t *child = CHILDREN(parent)[index];
+    node_t *right = _bp_tree_node_new(tree, child->level);
+
+    if (!right) {
+        return false;
+    }
+
+    const uint32_t middle = child->count / 2;
+    const void *separator;
+
+    if (IS_LEAF(child)) {
+        right->count = child->count - middle;
+        mem_copy(LEAF_KEY(tree, right, 0), LEAF_KEY(tree, child, middle), right->count * tree->typeSize);
+
+        right->next = child->next;
+        if (right->next) {
+            right->next->prev = right;
+        }
+        right->prev = child;
+        child->next = right;
+
+        separator = LEAF_KEY(tree, right, 0);
+    } else {
+        /*Middle key moves up, it stays readable in child until parent copies it*/
+        right->count = child->count - middle - 1;
+        mem_copy(INNER_KEY(tree, right, 0), INNER_KEY(tree, child, middle + 1), right->count * tree->typeSize);
+        mem_copy(CHILDREN(right), CHILDREN(child) + middle + 1, (right->count + 1) * sizeof(node_t *));
+
+        separator = INNER_KEY(tree, child, middle);
+    }
+
+    child->count = middle;
+
+    mem_copy(INNER_KEY(tree, parent, index + 1), INNER_KEY(tree, parent, index),
+             (parent->count - index) * tree->typeSize);
+    mem_copy(CHILDREN(parent) + index + 2, CHILDREN(parent) + index + 1,
+             (parent->count - index) * sizeof(node_t *));
+
+    mem_copy(INNER_KEY(tree, parent, index), separator, tree->typeSize);
+    CHILDREN(parent)[index + 1] = right;
+    parent->count++;
+
+    return true;
+}
+
+void *bp_tree_insert(bp_tree_t *tree, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    if (!tree->root) {
+        tree->root = _bp_tree_node_new(tree, 0);
+
+        if (!tree->root) {
+            return NULL;
+        }
+    }
+
+    /*Full nodes are split on the way down, so splits never go back up*/
+    if (IS_FULL(tree, tree->root)) {
+        node_t *root = _bp_tree_node_new(tree, tree->root->level + 1);
+
+        if (!root) {
+            return NULL;
+        }
+
+        CHILDREN(root)[0] = tree->root;
+
+        if (!_bp_tree_split(tree, root, 0)) {
+            alloc_free(tree->alloc, root);
+            return NULL;
+        }
+
+        tree->root = root;
+    }
+
+    node_t *node = tree->root;
+    while (!IS_LEAF(node)) {
+        uint32_t index = _bp_tree_child(tree, node, ptr);
+        node_t *child = CHILDREN(node)[index];
+
+        if (IS_FULL(tree, child)) {
+            if (!_bp_tree_split(tree, node, index)) {
+                return NULL;
+            }
+
+            if (tree->compare(ptr, INNER_KEY(tree, node, index)) >= 0) {
+                index++;
+            }
+
+            child = CHILDREN(node)[index];
+        }
+
+        node = child;
+    }
+
+    bool equal;
+    const uint32_t index = _bp_tree_lower(tree, node, ptr, &equal);
+
+    if (equal) {
+        return NULL;
+    }
+
+    mem_copy(LEAF_KEY(tree, node, index + 1), LEAF_KEY(tree, node, index), (node->count - index) * tree->typeSize);
+    mem_copy(LEAF_KEY(tree, node, index), ptr, tree->typeSize);
+    node->count++;
+
+    tree->size++;
+    return LEAF_KEY(tree, node, index);
+}
+
+void *bp_tree_find(bp_tree_t *tree, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    node_t *node;
+    uint32_t index;
+    return _bp_tree_locate(tree, ptr, EQUAL, &node, &index) ? LEAF_KEY(tree, node, index) : NULL;
+}
+
+void *bp_tree_min(bp_tree_t *tree, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    node_t *node;
+    uint32_t index;
+    return _bp_tree_locate(tree, ptr, LOWER, &node, &index) ? LEAF_KEY(tree, node, index) : NULL;
+}
+
+void *bp_tree_max(bp_tree_t *tree, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    node_t *node;
+    uint32_t index;
+    return _bp_tree_locate(tree, ptr, UPPER, &node, &index) ? LEAF_KEY(tree, node, index) : NULL;
+}
+
+void bp_tree_foreach(bp_tree_t *tree, action_f func, void *data) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return;
+    }
+
+    for (node_t *node = _bp_tree_first_leaf(tree); node; node = node->next) {
+        for (uint32_t i = 0; i < node->count; i++) {
+            func(LEAF_KEY(tree, node, i), data);
+        }
+    }
+}
+
+iter_t *bp_tree_iter(bp_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    node_t *node = _bp_tree_first_leaf(tree);
+    if (node && !node->count) {
+        node = NULL;
+    }
+
+    iter_t *iter;
+    CREATE_ITER(iter, tree->iterPool, node, 0, tree->typeSize);
+
+    return iter;
+}
+
+static iter_t *_bp_tree_locate_iter(bp_tree_t *tree, const void *ptr, uint32_t mode) {
+    node_t *node;
+    uint32_t index;
+
+    if (!_bp_tree_locate(tree, ptr, mode, &node, &index)) {
+        return NULL;
+    }
+
+    iter_t *iter;
+    CREATE_ITER(iter, tree->iterPool, node, index, tree->typeSize);
+
+    return iter;
+}
+
+iter_t *bp_tree_find_iter(bp_tree_t *tree, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    return _bp_tree_locate_iter(tree, ptr, EQUAL);
+}
+
+iter_t *bp_tree_min_iter(bp_tree_t *tree, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    return _bp_tree_locate_iter(tree, ptr, LOWER);
+}
+
+iter_t *bp_tree_max_iter(bp_tree_t *tree, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    return _bp_tree_locate_iter(tree, ptr, UPPER);
+}
+
+/*Refills child at index from a sibling, merging them when both are minimal*/
+static void _bp_tree_fix(bp_tree_t *tree, node_t *parent, uint32_t index) {
+    node_t *child = CHILDREN(parent)[index];
+    node_t *left = index ? CHILDREN(parent)[index - 1] : NULL;
+    node_t *right = index < parent->count ? CHILDREN(parent)[index + 1] : NULL;
+
+    if (left && left->count > MIN_COUNT(tree, left)) {
+        /*Borrowing last of left*/
+        if (IS_LEAF(child)) {
+            mem_copy(LEAF_KEY(tree, child, 1), LEAF_KEY(tree, child, 0), child->count * tree->typeSize);
+            mem_copy(LEAF_KEY(tree, child, 0), LEAF_KEY(tree, left, left->count - 1), tree->typeSize);
+            mem_copy(INNER_KEY(tree, parent, index - 1), LEAF_KEY(tree, child, 0), tree->typeSize);
+        } else {
+            mem_copy(INNER_KEY(tree, child, 1), INNER_KEY(tree, child, 0), child->count * tree->typeSize);
+            mem_copy(CHILDREN(child) + 1, CHILDREN(child), (child->count + 1) * sizeof(node_t *));
+            mem_copy(INNER_KEY(tree, child, 0), INNER_KEY(tree, parent, index - 1), tree->typeSize);
+            CHILDREN(child)[0] = CHILDREN(left)[left->count];
+            mem_copy(INNER_KEY(tree, parent, index - 1), INNER_KEY(tree, left, left->count - 1), tree->typeSize);
+        }
+
+        left->count--;
+        child->count++;
+    } else if (right && right->count > MIN_COUNT(tree, right)) {
+        /*Borrowing first of right*/
+        if (IS_LEAF(child)) {
+            mem_copy(LEAF_KEY(tree, child, child->count), LEAF_KEY(tree, right, 0), tree->typeSize);
+            mem_copy(LEAF_KEY(tree, right, 0), LEAF_KEY(tree, right, 1), (right->count - 1) * tree->typeSize);
+            mem_copy(INNER_KEY(tree, parent, index), LEAF_KEY(tree, right, 0), tree->typeSize);
+        } else {
+            mem_copy(INNER_KEY(tree, child, child->count), INNER_KEY(tree, parent, index), tree->typeSize);
+            CHILDREN(child)[child->count + 1] = CHILDREN(right)[0];
+            mem_copy(INNER_KEY(tree, parent, index), INNER_KEY(tree, right, 0), tree->typeSize);
+            mem_copy(INNER_KEY(tree, right, 0), INNER_KEY(tree, right, 1), (right->count - 1) * tree->typeSize);
+            mem_copy(CHILDREN(right), CHILDREN(right) + 1, right->count * sizeof(node_t *));
+        }
+
+        right->count--;
+        child->count++;
+    } else {
+        /*Merging pair at separator into the left one*/
+        if (left) {
+            right = child;
+            index--;
+        } else {
+            left = child;
+        }
+
+        if (IS_LEAF(left)) {
+            mem_copy(LEAF_KEY(tree, left, left->count), LEAF_KEY(tree, right, 0), right->count * tree->typeSize);
+            left->count += right->count;
+
+            left->next = right->next;
+            if (left->next) {
+                left->next->prev = left;
+            }
+        } else {
+            mem_copy(INNER_KEY(tree, left, left->count), INNER_KEY(tree, parent, index), tree->typeSize);
+            mem_copy(INNER_KEY(tree, left, left->count + 1), INNER_KEY(tree, right, 0), right->count * tree->typeSize);
+            mem_copy(CHILDREN(left) + left->count + 1, CHILDREN(right), (right->count + 1) * sizeof(node_t *));
+            left->count += right->count + 1;
+        }
+
+        alloc_free(tree->alloc, right);
+
+        mem_copy(INNER_KEY(tree, parent, index), INNER_KEY(tree, parent, index + 1),
+                 (parent->count - index - 1) * tree->typeSize);
+        mem_copy(CHILDREN(parent) + index + 1, CHILDREN(parent) + index + 2,
+                 (parent->count - index - 1) * sizeof(node_t *));
+        parent->count--;
+    }
+}
+
+static bool _bp_tree_remove(bp_tree_t *tree, node_t *node, const void *ptr, void *dst) {
+    if (IS_LEAF(node)) {
+        bool equal;
+        const uint32_t index = _bp_tree_lower(tree, node, ptr, &equal);
+
+        if (!equal) {
+            return false;
+        }
+
+        if (dst) {
+            mem_copy(dst, LEAF_KEY(tree, node, index), tree->typeSize);
+        }
+
+        mem_copy(LEAF_KEY(tree, node, index), LEAF_KEY(tree, node, index + 1),
+                 (node->count - index - 1) * tree->typeSize);
+        node->count--;
+
+        return true;
+    }
+
+    const uint32_t index = _bp_tree_child(tree, node, ptr);
+    node_t *child = CHILDREN(node)[index];
+
+    if (!_bp_tree_remove(tree, child, ptr, dst)) {
+        return false;
+    }
+
+    /*Separators may outlive removed elements, they still split ranges correctly*/
+    if (child->count < MIN_COUNT(tree, child)) {
+        _bp_tree_fix(tree, node, index);
+    }
+
+    return true;
+}
+
+#define BP_TREE_REMOVE(tree, ptr, dst)\
+do {\
+    if (!tree->root || !_bp_tree_remove(tree, tree->root, ptr, dst)) {\
+        return false;\
+    }\
+    \
+    if (!tree->root->count) {\
+        node_t *root = tree->root;\
+        tree->root = IS_LEAF(root) ? NULL : CHILDREN(root)[0];\
+        alloc_free(tree->alloc, root);\
+    }\
+    \
+    tree->size--;\
+    return true;\
+} while (0)
+
+bool bp_tree_remove(bp_tree_t *tree, const void *ptr, void *dst) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return false;
+    }
+
+    BP_TREE_REMOVE(tree, ptr, dst);
+}
+
+/*Located element is copied aside, as removal moves elements inside nodes*/
+static bool _bp_tree_remove_at(bp_tree_t *tree, node_t *node, uint32_t index, void *dst) {
+    mem_copy(tree->buffer, LEAF_KEY(tree, node, index), tree->typeSize);
+    BP_TREE_REMOVE(tree, tree->buffer, dst);
+}
+
+bool bp_tree_remove_min(bp_tree_t *tree, const void *ptr, void *dst) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return false;
+    }
+
+    node_t *node;
+    uint32_t index;
+    if (!_bp_tree_locate(tree, ptr, LOWER, &node, &index)) {
+        return false;
+    }
+
+    return _bp_tree_remove_at(tree, node, index, dst);
+}
+
+bool bp_tree_remove_max(bp_tree_t *tree, const void *ptr, void *dst) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return false;
+    }
+
+    node_t *node;
+    uint32_t index;
+    if (!_bp_tree_locate(tree, ptr, UPPER, &node, &index)) {
+        return false;
+    }
+
+    return _bp_tree_remove_at(tree, node, index, dst);
+}
+
+bool bp_tree_remove_iter(bp_tree_t *tree, iter_t *iter, void *dst) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return false;
+    }
+
+    node_t *node = ITER(iter)->node;
+    const uint32_t index = ITER(iter)->index;
+    iter_term(iter);
+
+    if (!node) {
+        return false;
+    }
+
+    return _bp_tree_remove_at(tree, node, index, dst);
+}
+
+bool bp_tree_remove_iter_tmp(bp_tree_t *tree, bp_tree_iter_s *iter, void *dst) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return false;
+    }
+
+    if (!iter->node) {
+        return false;
+    }
+
+    node_t *node = iter->node;
+    iter->node = NULL;
+
+    return _bp_tree_remove_at(tree, node, iter->index, dst);
+}
+
+uint32_t bp_tree_size(bp_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return 0;
+    }
+
+    return tree->size;
+}
+
+void bp_tree_clear(bp_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return;
+    }
+
+    if (tree->root) {
+        _bp_tree_free_nodes(tree, tree->root);
+    }
+
+    tree->root = NULL;
+    tree->size = 0;
+}
@@ -0,0 +1,240 @@
+#include "meal/crb_tree.h"
+
+#include "meal/rb_tree.h"
+#include "meal/list_pool.h"
+#include "meal/assert.h"
+#include "meal/memory.h"
+#include "rb_tree.h"
+
+#include <stdatomic.h>
+
+#define TAG "CRB Tree"
+
+#define CACHE_LINE 64
+
+#define STRIPES 16
+
+/*Longer search means that reader walked into a half rotated path*/
+#define MAX_DEPTH 64
+
+typedef struct retired_t retired_t;
+
+typedef struct retired_t {
+    retired_t *next;
+    void *node;
+} retired_t;
+
+/*Readers announce themselves in the stripe of their thread for the epoch they entered*/
+typedef struct stripe_t {
+    atomic_uint active[2];
+    char pad[CACHE_LINE - 2 * sizeof(atomic_uint)];
+} stripe_t;
+
+typedef struct crb_tree_t {
+    const alloc_t *alloc;
+    rb_tree_t *tree;
+    list_pool_t *retiredPool;
+    retired_t *retired[2];
+    uint32_t typeSize;
+    atomic_flag lock;
+    char padSeq[CACHE_LINE];
+    atomic_uint seq;
+    atomic_uint epoch;
+    atomic_uint size;
+    char padStripes[CACHE_LINE];
+    stripe_t stripes[STRIPES];
+} crb_tree_t;
+
+static atomic_uint stripeCounter;
+
+static _Thread_local uint32_t threadStripe = STRIPES;
+
+/*Unlinked node is kept until every reader of the epoch it was unlinked in has left*/
+static void _crb_tree_retire(void *node, void *data) {
+    crb_tree_t *tree = data;
+    retired_t *retired = list_pool_get(tree->retiredPool);
+
+    /*Leaking is the only safe choice while readers may still hold the node*/
+    ASSERT_ERROR(retired, TAG, "Can't allocate memory for retired node") {
+        return;
+    }
+
+    const uint32_t epoch = atomic_load_explicit(&tree->epoch, memory_order_relaxed);
+    retired->node = node;
+    retired->next = tree->retired[epoch & 1];
+    tree->retired[epoch & 1] = retired;
+}
+
+crb_tree_t *crb_tree_init_via(const alloc_t *alloc, cmp_f compare, uint32_t typeSize, uint32_t bufferSize) {
+    crb_tree_t *tree = alloc_malloc(alloc, sizeof(crb_tree_t));
+
+    ASSERT_ERROR(tree, TAG, "Can't allocate memory for tree") {
+        return NULL;
+    }
+
+    tree->tree = rb_tree_init_via(alloc, compare, typeSize, bufferSize);
+
+    if (!tree->tree) {
+        alloc_free(alloc, tree);
+        return NULL;
+    }
+
+    tree->retiredPool = list_pool_init_via(alloc, sizeof(retired_t), bufferSize);
+
+    ASSERT_ERROR(tree->retiredPool, TAG, "Can't allocate memory for pool") {
+        rb_tree_term(tree->tree);
+        alloc_free(alloc, tree);
+        return NULL;
+    }
+
+    rb_tree_retire_via(tree->tree, _crb_tree_retire, tree);
+
+    tree->alloc = alloc;
+    tree->retired[0] = NULL;
+    tree->retired[1] = NULL;
+    tree->typeSize = typeSize;
+    atomic_flag_clear(&tree->lock);
+    atomic_init(&tree->seq, 0);
+    atomic_init(&tree->epoch, 0);
+    atomic_init(&tree->size, 0);
+
+    for (uint32_t i = 0; i < STRIPES; i++) {
+        atomic_init(&tree->stripes[i].active[0], 0);
+        atomic_init(&tree->stripes[i].active[1], 0);
+    }
+
+    return tree;
+}
+
+void crb_tree_term(crb_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return;
+    }
+
+    rb_tree_term(tree->tree);
+    list_pool_term(tree->retiredPool);
+    alloc_free(tree->alloc, tree);
+}
+
+static void _crb_tree_lock(crb_tree_t *tree) {
+    while (atomic_flag_test_and_set_explicit(&tree->lock, memory_order_acquire));
+
+    const uint32_t seq = atomic_load_explicit(&tree->seq, memory_order_relaxed);
+    atomic_store_explicit(&tree->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void _crb_tree_publish(crb_tree_t *tree) {
+    const uint32_t seq = atomic_load_explicit(&tree->seq, memory_order_relaxed);
+    atomic_store_explicit(&tree->seq, seq + 1, memory_order_release);
+    atomic_store_explicit(&tree->size, rb_tree_size(tree->tree), memory_order_relaxed);
+}
+
+static void _crb_tree_unlock(crb_tree_t *tree) {
+    atomic_flag_clear_explicit(&tree->lock, memory_order_release);
+}
+
+/*Readers of epoch e - 1 are the only ones that could reach nodes retired in e - 1;*/
+/*once they are gone those nodes go back to the pool and the epoch moves on*/
+static void _crb_tree_reclaim(crb_tree_t *tree) {
+    const uint32_t epoch = atomic_load_explicit(&tree->epoch, memory_order_relaxed);
+    const uint32_t old = (epoch + 1) & 1;
+
+    for (uint32_t i = 0; i < STRIPES; i++) {
+        if (atomic_load_explicit(&tree->stripes[i].active[old], memory_order_acquire)) {
+            return;
+        }
+    }
+
+    while (tree->retired[old]) {
+        retired_t *retired = tree->retired[old];
+        tree->retired[old] = retired->next;
+        rb_tree_free_node(tree->tree, retired->node);
+        list_pool_free(tree->retiredPool, retired);
+    }
+
+    atomic_store_explicit(&tree->epoch, epoch + 1, memory_order_seq_cst);
+}
+
+bool crb_tree_insert(crb_tree_t *tree, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    _crb_tree_lock(tree);
+    const uint32_t size = rb_tree_size(tree->tree);
+    const bool result = rb_tree_insert(tree->tree, ptr) && rb_tree_size(tree->tree) != size;
+    _crb_tree_publish(tree);
+    _crb_tree_unlock(tree);
+
+    return result;
+}
+
+bool crb_tree_remove(crb_tree_t *tree, const void *ptr, void *dst) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    _crb_tree_lock(tree);
+    const bool result = rb_tree_remove(tree->tree, ptr, dst);
+    _crb_tree_publish(tree);
+    if (result) {
+        _crb_tree_reclaim(tree);
+    }
+    _crb_tree_unlock(tree);
+
+    return result;
+}
+
+static stripe_t *_crb_tree_enter(crb_tree_t *tree, uint32_t *epoch) {
+    if (threadStripe == STRIPES) {
+        threadStripe = atomic_fetch_add_explicit(&stripeCounter, 1, memory_order_relaxed) % STRIPES;
+    }
+
+    stripe_t *stripe = &tree->stripes[threadStripe];
+    while (true) {
+        *epoch = atomic_load_explicit(&tree->epoch, memory_order_seq_cst);
+        atomic_fetch_add_explicit(&stripe->active[*epoch & 1], 1, memory_order_seq_cst);
+        if (atomic_load_explicit(&tree->epoch, memory_order_seq_cst) == *epoch) {
+            return stripe;
+        }
+        atomic_fetch_sub_explicit(&stripe->active[*epoch & 1], 1, memory_order_release);
+    }
+}
+
+bool crb_tree_find(crb_tree_t *tree, const void *ptr, void *dst) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return false;
+    }
+
+    uint32_t epoch;
+    stripe_t *stripe = _crb_tree_enter(tree, &epoch);
+
+    bool result;
+    uint32_t seq;
+    do {
+        while ((seq = atomic_load_explicit(&tree->seq, memory_order_acquire)) & 1);
+
+        const void *data = rb_tree_find_bounded(tree->tree, ptr, MAX_DEPTH);
+        if ((result = data) && dst) {
+            mem_copy(dst, data, tree->typeSize);
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+    } while (atomic_load_explicit(&tree->seq, memory_order_relaxed) != seq);
+
+    atomic_fetch_sub_explicit(&stripe->active[epoch & 1], 1, memory_order_release);
+    return result;
+}
+
+uint32_t crb_tree_size(crb_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return 0;
+    }
+
+    return atomic_load_explicit(&tree->size, memory_order_relaxed);
+}
@@ -0,0 +1,381 @@
+#include "meal/deque.h"
+
+#include "meal/memory.h"
+#include "meal/assert.h"
+
+#define TAG "Deque"
+
+#define MAP_SIZE 8
+
+/*Elements live in fixed leaf buffers, the same way hash stack keeps them*/
+/*Only map of buffer pointers is moved on growth, elements never are*/
+typedef struct deque_t {
+    const alloc_t *alloc;
+    uint32_t typeSize;
+    uint32_t bufferSize;
+    uint32_t bufferShift;
+    uint32_t bufferMask;
+    uint32_t size;
+    uint32_t mapSize;
+    uint64_t start;
+    void **map;
+    void *spare;
+} deque_t;
+
+static uint32_t _deque_log2(uint32_t value) {
+    uint32_t shift = 0;
+    while ((1u << shift) < value) {
+        shift++;
+    }
+    return shift;
+}
+
+deque_t *deque_init_via(const alloc_t *alloc, uint32_t typeSize, uint32_t bufferSize) {
+    ASSERT_ERROR(typeSize, TAG, "TypeSize must be more than 0: typeSize = %d", typeSize) {
+        return NULL;
+    }
+
+    ASSERT_ERROR(bufferSize > 1 && bufferSize <= (1u << 31), TAG, "BufferSize must be in (1; 2^31]: "
+                                                                  "bufferSize = %u", bufferSize) {
+        return NULL;
+    }
+
+    deque_t *deque = alloc_malloc(alloc, sizeof(deque_t));
+
+    ASSERT_ERROR(deque, TAG, "Can't allocate memory for deque") {
+        return NULL;
+    }
+
+    deque->map = alloc_malloc(alloc, sizeof(void *) * MAP_SIZE);
+
+    ASSERT_ERROR(deque->map, TAG, "Can't allocate memory for deque map") {
+        alloc_free(alloc, deque);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < MAP_SIZE; i++) {
+        deque->map[i] = NULL;
+    }
+
+    /*Buffer size is rounded to power of two for shift and mask addressing*/
+    deque->alloc = alloc;
+    deque->typeSize = typeSize;
+    deque->bufferShift = _deque_log2(bufferSize);
+    deque->bufferSize = 1u << deque->bufferShift;
+    deque->bufferMask = deque->bufferSize - 1;
+    deque->size = 0;
+    deque->mapSize = MAP_SIZE;
+    deque->start = 0;
+    deque->spare = NULL;
+
+    return deque;
+}
+
+void deque_term(deque_t *deque) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return;
+    }
+
+    deque_clear(deque);
+
+    if (deque->spare) {
+        alloc_free(deque->alloc, deque->spare);
+    }
+
+    alloc_free(deque->alloc, deque->map);
+    alloc_free(deque->alloc, deque);
+}
+
+#define DEQUE_BLOCK(deque, pos) ((uint32_t)((pos) >> deque->bufferShift))
+
+#define DEQUE_SLOT(deque, pos) (deque->map[DEQUE_BLOCK(deque, pos)] + ((pos) & deque->bufferMask) * deque->typeSize)
+
+/*Recenters used part of the map, doubling the map if it is more than half full*/
+static bool _deque_map_grow(deque_t *deque) {
+    const uint32_t first = DEQUE_BLOCK(deque, deque->start);
+    const uint32_t used = deque->size ? DEQUE_BLOCK(deque, deque->start + deque->size - 1) - first + 1 : 0;
+
+    uint32_t mapSize = deque->mapSize;
+    void **map = deque->map;
+
+    if (used + 2 > mapSize / 2) {
+        ASSERT_ERROR(mapSize <= UINT32_MAX / 2, TAG, "Deque map is too big: mapSize = %u", mapSize) {
+            return false;
+        }
+
+        mapSize *= 2;
+        map = alloc_malloc(deque->alloc, sizeof(void *) * mapSize);
+
+        ASSERT_ERROR(map, TAG, "Can't allocate memory for deque map") {
+            return false;
+        }
+    }
+
+    const uint32_t newFirst = (mapSize - used) / 2;
+
+    if (map != deque->map) {
+        for (uint32_t i = 0; i < used; i++) {
+            map[newFirst + i] = deque->map[first + i];
+        }
+        alloc_free(deque->alloc, deque->map);
+    } else if (newFirst < first) {
+        for (uint32_t i = 0; i < used; i++) {
+            map[newFirst + i] = map[first + i];
+        }
+    } else {
+        for (uint32_t i = used; i > 0; i--) {
+            map[newFirst + i - 1] = map[first + i - 1];
+        }
+    }
+
+    for (uint32_t i = 0; i < newFirst; i++) {
+        map[i] = NULL;
+    }
+    for (uint32_t i = newFirst + used; i < mapSize; i++) {
+        map[i] = NULL;
+    }
+
+    deque->map = map;
+    deque->mapSize = mapSize;
+    deque->start = ((uint64_t)newFirst << deque->bufferShift) + (deque->start & deque->bufferMask);
+
+    return true;
+}
+
+static void *_deque_block_new(deque_t *deque) {
+    void *block = deque->spare;
+
+    if (block) {
+        deque->spare = NULL;
+    } else {
+        block = alloc_malloc(deque->alloc, deque->typeSize * deque->bufferSize);
+
+        ASSERT_ERROR(block, TAG, "Can't allocate memory for deque data") {
+            return NULL;
+        }
+    }
+
+    return block;
+}
+
+/*Single emptied buffer is kept, so queue running over buffer border doesn't allocate every time*/
+static void _deque_block_release(deque_t *deque, uint32_t index) {
+    if (deque->spare) {
+        alloc_free(deque->alloc, deque->map[index]);
+    } else {
+        deque->spare = deque->map[index];
+    }
+
+    deque->map[index] = NULL;
+}
+
+#define DEQUE_RESET(deque) (deque->start = (uint64_t)(deque->mapSize / 2) << deque->bufferShift)
+
+void *deque_push_back(deque_t *deque, const void *ptr) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(deque->size < UINT32_MAX, TAG, "Deque is full") {
+        return NULL;
+    }
+
+    if (!deque->size) {
+        DEQUE_RESET(deque);
+    }
+
+    if (DEQUE_BLOCK(deque, deque->start + deque->size) >= deque->mapSize) {
+        if (!_deque_map_grow(deque)) {
+            return NULL;
+        }
+    }
+
+    const uint64_t pos = deque->start + deque->size;
+    const uint32_t block = DEQUE_BLOCK(deque, pos);
+
+    if (!deque->map[block]) {
+        deque->map[block] = _deque_block_new(deque);
+
+        if (!deque->map[block]) {
+            return NULL;
+        }
+    }
+
+    void *dst = DEQUE_SLOT(deque, pos);
+    mem_copy(dst, ptr, deque->typeSize);
+
+    deque->size++;
+    return dst;
+}
+
+void *deque_push_front(deque_t *deque, const void *ptr) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(deque->size < UINT32_MAX, TAG, "Deque is full") {
+        return NULL;
+    }
+
+    if (!deque->size) {
+        DEQUE_RESET(deque);
+    }
+
+    if (!deque->start) {
+        if (!_deque_map_grow(deque)) {
+            return NULL;
+        }
+    }
+
+    const uint64_t pos = deque->start - 1;
+    const uint32_t block = DEQUE_BLOCK(deque, pos);
+
+    if (!deque->map[block]) {
+        deque->map[block] = _deque_block_new(deque);
+
+        if (!deque->map[block]) {
+            return NULL;
+        }
+    }
+
+    void *dst = DEQUE_SLOT(deque, pos);
+    mem_copy(dst, ptr, deque->typeSize);
+
+    deque->start = pos;
+    deque->size++;
+    return dst;
+}
+
+bool deque_pop_back(deque_t *deque, void *dst) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return false;
+    }
+
+    if (!deque->size) {
+        return false;
+    }
+
+    deque->size--;
+    const uint64_t pos = deque->start + deque->size;
+
+    if (dst) {
+        mem_copy(dst, DEQUE_SLOT(deque, pos), deque->typeSize);
+    }
+
+    if (!deque->size || !(pos & deque->bufferMask)) {
+        _deque_block_release(deque, DEQUE_BLOCK(deque, pos));
+    }
+
+    return true;
+}
+
+bool deque_pop_front(deque_t *deque, void *dst) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return false;
+    }
+
+    if (!deque->size) {
+        return false;
+    }
+
+    const uint64_t pos = deque->start;
+
+    if (dst) {
+        mem_copy(dst, DEQUE_SLOT(deque, pos), deque->typeSize);
+    }
+
+    deque->start++;
+    deque->size--;
+
+    if (!deque->size || !(deque->start & deque->bufferMask)) {
+        _deque_block_release(deque, DEQUE_BLOCK(deque, pos));
+    }
+
+    return true;
+}
+
+void *deque_front(deque_t *deque) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return NULL;
+    }
+
+    if (!deque->size) {
+        return NULL;
+    }
+
+    return DEQUE_SLOT(deque, deque->start);
+}
+
+void *deque_back(deque_t *deque) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return NULL;
+    }
+
+    if (!deque->size) {
+        return NULL;
+    }
+
+    return DEQUE_SLOT(deque, deque->start + deque->size - 1);
+}
+
+void *deque_at(deque_t *deque, uint32_t index) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(index < deque->size, TAG, "Index must be less than deque size: "
+                                           "size = %d; index = %d", deque->size, index) {
+        return NULL;
+    }
+
+    return DEQUE_SLOT(deque, deque->start + index);
+}
+
+uint32_t deque_size(deque_t *deque) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return 0;
+    }
+
+    return deque->size;
+}
+
+uint32_t deque_type_size(deque_t *deque) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return 0;
+    }
+
+    return deque->typeSize;
+}
+
+uint32_t deque_buffer_size(deque_t *deque) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return 0;
+    }
+
+    return deque->bufferSize;
+}
+
+void deque_clear(deque_t *deque) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return;
+    }
+
+    if (deque->size) {
+        const uint32_t first = DEQUE_BLOCK(deque, deque->start);
+        const uint32_t last = DEQUE_BLOCK(deque, deque->start + deque->size - 1);
+
+        for (uint32_t i = first; i <= last; i++) {
+            _deque_block_release(deque, i);
+        }
+    }
+
+    deque->size = 0;
+}
@@ -2,20 +2,36 @@
 
 #include "meal/memory.h"
 #include "meal/macros.h"
+#include "meal/math.h"
 #include "meal/assert.h"
 
 #define TAG "Hash Stack"
 
+#define MAX_LEVELS 32
+
 typedef struct hash_stack_t {
     const alloc_t *alloc;
     uint32_t typeSize;
     uint32_t bufferSize;
+    uint32_t bufferShift;
+    uint32_t bufferMask;
     uint32_t size;
     uint32_t levels;
+    uint32_t leaves;
+    uint32_t reserved;
+    bool autoShrink;
     unsigned long long cap;
     void *data;
 } hash_stack_t;
 
+static uint32_t _hash_stack_log2(uint32_t value) {
+    uint32_t shift = 0;
+    while ((1u << shift) < value) {
+        shift++;
+    }
+    return shift;
+}
+
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "OCDFAInspection"
 hash_stack_t *hash_stack_init_via(const alloc_t *alloc, uint32_t typeSize, uint32_t bufferSize) {
@@ -36,8 +52,19 @@ hash_stack_t *hash_stack_init_via(const alloc_t *alloc, uint32_t typeSize, uint3
     stack->alloc = alloc;
     stack->typeSize = typeSize;
     stack->bufferSize = bufferSize;
+
+    if (bufferSize & (bufferSize - 1)) {
+        stack->bufferShift = 0;
+        stack->bufferMask = 0;
+    } else {
+        stack->bufferShift = _hash_stack_log2(bufferSize);
+        stack->bufferMask = bufferSize - 1;
+    }
+
     stack->size = 0;
     stack->levels = 0;
+    stack->reserved = 0;
+    stack->autoShrink = true;
 
     stack->data = alloc_malloc(alloc, stack->typeSize * stack->bufferSize);
 
@@ -47,17 +74,26 @@ hash_stack_t *hash_stack_init_via(const alloc_t *alloc, uint32_t typeSize, uint3
     }
 
     stack->cap = stack->bufferSize;
+    stack->leaves = 1;
 
     return stack;
 }
 #pragma clang diagnostic pop
 
+hash_stack_t *hash_stack_init_pow2_via(const alloc_t *alloc, uint32_t typeSize, uint32_t bufferSize) {
+    ASSERT_ERROR(bufferSize <= (1u << 31), TAG, "BufferSize is too big to round: bufferSize = %u", bufferSize) {
+        return NULL;
+    }
+
+    return hash_stack_init_via(alloc, typeSize, 1u << _hash_stack_log2(bufferSize));
+}
+
 static void _hash_stack_clear(const alloc_t *alloc, void *data, uint32_t size, uint32_t level);
 
 #define HASH_STACK_CLEAR(stack) \
 if (stack->levels) {\
     _hash_stack_clear(stack->alloc, stack->data, stack->bufferSize, stack->levels);\
-} else if (stack->levels > 1) {\
+} else if (stack->data) {\
     alloc_free(stack->alloc, stack->data);\
 }\
 
@@ -71,27 +107,55 @@ void hash_stack_term(hash_stack_t *stack) {
     alloc_free(stack->alloc, stack);
 }
 
-#define HASH_STACK_ADDRESS(stack, address, index)\
-uint32_t __INDEX = index;\
-uint32_t address = __INDEX % stack->bufferSize;\
-LOOP(i, stack->levels) {\
-    __INDEX /= stack->bufferSize;\
-    address *= stack->bufferSize;\
-    address += __INDEX % stack->bufferSize;\
+#define HASH_STACK_DIVMOD(stack, value, quot, rem)\
+do {\
+    uint32_t __VALUE = value;\
+    if (stack->bufferShift) {\
+        quot = __VALUE >> stack->bufferShift;\
+        rem = __VALUE & stack->bufferMask;\
+    } else {\
+        quot = __VALUE / stack->bufferSize;\
+        rem = __VALUE - quot * stack->bufferSize;\
+    }\
+} while (0)
+
+/*Digits of index in bufferSize base, lowest digit is offset in leaf buffer*/
+/*Power of two sizes take digits by shift and mask directly*/
+#define HASH_STACK_DIGITS(stack, digits, index)\
+uint32_t digits[MAX_LEVELS + 1];\
+if (!stack->bufferShift) {\
+    uint32_t __INDEX = index;\
+    for (uint32_t __LEVEL = 0; __LEVEL <= stack->levels; __LEVEL++) {\
+        HASH_STACK_DIVMOD(stack, __INDEX, __INDEX, digits[__LEVEL]);\
+    }\
+}
+
+#define HASH_STACK_DIGIT(stack, digits, index, level)\
+(stack->bufferShift ? (uint32_t)(((uint64_t)(index) >> (stack->bufferShift * (level))) & stack->bufferMask) : digits[level])
+
+#define HASH_STACK_PEEK(stack, index, ptr)\
+HASH_STACK_DIGITS(stack, __DIGITS, index)\
+void **__ARRAY = stack->data;\
+for (uint32_t __LEVEL = stack->levels; __LEVEL > 0; __LEVEL--) {\
+    __ARRAY = __ARRAY[HASH_STACK_DIGIT(stack, __DIGITS, index, __LEVEL)];\
 }\
+void *ptr = (void *)__ARRAY + stack->typeSize * HASH_STACK_DIGIT(stack, __DIGITS, index, 0);
 
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "OCDFAInspection"
-void *hash_stack_push(hash_stack_t *stack, const void *ptr) {
-    ASSERT_ERROR(stack, TAG, "NULL stack") {
-        return NULL;
-    }
+static void *_hash_stack_slot(hash_stack_t *stack, uint32_t index) {
+    if (!stack->data) {
+        stack->data = alloc_malloc(stack->alloc, stack->typeSize * stack->bufferSize);
 
-    ASSERT_ERROR(ptr, TAG, "NULL data") {
-        return NULL;
+        ASSERT_ERROR(stack->data, TAG, "Can't allocate memory for stack data") {
+            return NULL;
+        }
+
+        stack->cap = stack->bufferSize;
+        stack->leaves = 1;
     }
 
-    if (stack->size == stack->cap) {
+    while (index >= stack->cap) {
         void **array = alloc_malloc(stack->alloc, sizeof(void *) * stack->bufferSize);
 
         ASSERT_ERROR(array, TAG, "Can't allocate memory for stack data") {
@@ -108,16 +172,16 @@ void *hash_stack_push(hash_stack_t *stack, const void *ptr) {
         stack->cap *= stack->bufferSize;
     }
 
-    void **array = stack->data;
-    HASH_STACK_ADDRESS(stack, address, stack->size)
+    HASH_STACK_DIGITS(stack, digits, index)
 
-    for (int32_t i = stack->levels - 1; i >= 0; i--) {
-        uint32_t mod = address % stack->bufferSize;
+    void **array = stack->data;
+    for (uint32_t level = stack->levels; level > 0; level--) {
+        uint32_t digit = HASH_STACK_DIGIT(stack, digits, index, level);
 
-        if (!array[mod]) {
+        if (!array[digit]) {
             void **newArray;
 
-            if (i) {
+            if (level > 1) {
                 newArray = alloc_malloc(stack->alloc, sizeof(void *) * stack->bufferSize);
 
                 ASSERT_ERROR(newArray, TAG, "Can't allocate memory for stack data") {
@@ -133,28 +197,205 @@ void *hash_stack_push(hash_stack_t *stack, const void *ptr) {
                 ASSERT_ERROR(newArray, TAG, "Can't allocate memory for stack data") {
                     return NULL;
                 }
+
+                stack->leaves++;
             }
 
-            array[mod] = newArray;
+            array[digit] = newArray;
         }
 
-        array = array[mod];
-        address /= stack->bufferSize;
+        array = array[digit];
+    }
+
+    return (void *)array + stack->typeSize * HASH_STACK_DIGIT(stack, digits, index, 0);
+}
+#pragma clang diagnostic pop
+
+void *hash_stack_push(hash_stack_t *stack, const void *ptr) {
+    ASSERT_ERROR(stack, TAG, "NULL stack") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    void *dst = _hash_stack_slot(stack, stack->size);
+
+    if (!dst) {
+        return NULL;
     }
 
-    void *dst = (void *)array + stack->typeSize * address;
     mem_copy(dst, ptr, stack->typeSize);
 
     stack->size++;
     return dst;
 }
-#pragma clang diagnostic pop
 
-#define HASH_STACK_PEEK(stack, address, array) \
-void **array = stack->data;\
-LOOP(i, stack->levels) {\
-    array = (void **)array[address % stack->bufferSize];\
-    address /= stack->bufferSize;\
+void *hash_stack_push_uninit(hash_stack_t *stack) {
+    ASSERT_ERROR(stack, TAG, "NULL stack") {
+        return NULL;
+    }
+
+    void *dst = _hash_stack_slot(stack, stack->size);
+
+    if (dst) {
+        stack->size++;
+    }
+
+    return dst;
+}
+
+void *hash_stack_push_n(hash_stack_t *stack, const void *ptr, uint32_t count) {
+    ASSERT_ERROR(stack, TAG, "NULL stack") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(count <= UINT32_MAX - stack->size, TAG, "Stack size overflow: size = %u, count = %u",
+                 stack->size, count) {
+        return NULL;
+    }
+
+    void *first = NULL;
+
+    while (count) {
+        void *dst = _hash_stack_slot(stack, stack->size);
+
+        if (!dst) {
+            return NULL;
+        }
+
+        first = first ? first : dst;
+
+        /*Filling rest of leaf buffer at once*/
+        uint32_t offset, chunk;
+        HASH_STACK_DIVMOD(stack, stack->size, chunk, offset);
+        chunk = MIN(stack->bufferSize - offset, count);
+
+        mem_copy(dst, ptr, stack->typeSize * chunk);
+
+        ptr += stack->typeSize * chunk;
+        stack->size += chunk;
+        count -= chunk;
+    }
+
+    return first;
+}
+
+bool hash_stack_reserve(hash_stack_t *stack, uint32_t count) {
+    ASSERT_ERROR(stack, TAG, "NULL stack") {
+        return false;
+    }
+
+    ASSERT_ERROR(count <= UINT32_MAX - stack->size, TAG, "Stack size overflow: size = %u, count = %u",
+                 stack->size, count) {
+        return false;
+    }
+
+    /*Touching first slot of every leaf buffer allocates it with all tables above*/
+    const uint32_t end = stack->size + count;
+
+    /*Auto shrink keeps reserved leaf buffers, so push/pop loops don't allocate them again*/
+    uint32_t leaves, rest;
+    HASH_STACK_DIVMOD(stack, end, leaves, rest);
+    stack->reserved = MAX(stack->reserved, leaves + (rest != 0));
+
+    uint32_t index = stack->size;
+    while (index < end) {
+        if (!_hash_stack_slot(stack, index)) {
+            return false;
+        }
+
+        uint32_t offset, quot;
+        HASH_STACK_DIVMOD(stack, index, quot, offset);
+
+        if (end - index <= stack->bufferSize - offset) {
+            break;
+        }
+        index += stack->bufferSize - offset;
+    }
+
+    return true;
+}
+
+/*Leaf buffers are always allocated as prefix, so freeing goes from the last one*/
+/*Tables left empty are freed with it, top table is collapsed while only first entry is used*/
+static void _hash_stack_trim(hash_stack_t *stack, uint32_t keep) {
+    keep = MAX(keep, 1u);
+
+    while (stack->leaves > keep) {
+        const uint32_t index = (stack->leaves - 1) * stack->bufferSize;
+        HASH_STACK_DIGITS(stack, digits, index)
+
+        void **path[MAX_LEVELS + 1];
+        void **array = stack->data;
+        for (uint32_t level = stack->levels; level > 0; level--) {
+            path[level] = array;
+            array = array[HASH_STACK_DIGIT(stack, digits, index, level)];
+        }
+
+        alloc_free(stack->alloc, array);
+        stack->leaves--;
+
+        for (uint32_t level = 1; level <= stack->levels; level++) {
+            const uint32_t digit = HASH_STACK_DIGIT(stack, digits, index, level);
+            path[level][digit] = NULL;
+
+            if (digit || level == stack->levels) {
+                break;
+            }
+            alloc_free(stack->alloc, path[level]);
+        }
+    }
+
+    while (stack->levels && stack->leaves <= stack->cap / stack->bufferSize / stack->bufferSize) {
+        void **array = stack->data;
+        stack->data = array[0];
+        alloc_free(stack->alloc, array);
+
+        stack->levels--;
+        stack->cap /= stack->bufferSize;
+    }
+}
+
+#define HASH_STACK_USED_LEAVES(stack, used)\
+uint32_t used, __OFFSET;\
+HASH_STACK_DIVMOD(stack, stack->size, used, __OFFSET);\
+used += __OFFSET != 0;
+
+/*Hysteresis: releasing only when under quarter of leaf buffers is used, keeping half and the reserve*/
+#define HASH_STACK_AUTO_SHRINK(stack)\
+if (stack->autoShrink && stack->leaves >= 4 && stack->leaves > stack->reserved) {\
+    HASH_STACK_USED_LEAVES(stack, used)\
+    if (used <= stack->leaves / 4) {\
+        _hash_stack_trim(stack, MAX(used * 2, stack->reserved));\
+    }\
+}
+
+void hash_stack_shrink(hash_stack_t *stack) {
+    ASSERT_ERROR(stack, TAG, "NULL stack") {
+        return;
+    }
+
+    /*Explicit shrink releases the reserve too*/
+    stack->reserved = 0;
+
+    if (stack->data) {
+        HASH_STACK_USED_LEAVES(stack, used)
+        _hash_stack_trim(stack, used);
+    }
+}
+
+void hash_stack_auto_shrink(hash_stack_t *stack, bool enable) {
+    ASSERT_ERROR(stack, TAG, "NULL stack") {
+        return;
+    }
+
+    stack->autoShrink = enable;
 }
 
 void hash_stack_pop_count(hash_stack_t *stack, uint32_t count) {
@@ -173,6 +414,8 @@ void hash_stack_pop_count(hash_stack_t *stack, uint32_t count) {
     }
 
     stack->size -= count;
+
+    HASH_STACK_AUTO_SHRINK(stack)
 }
 
 void *hash_stack_peek_offset(hash_stack_t *stack, uint32_t index) {
@@ -189,10 +432,74 @@ void *hash_stack_peek_offset(hash_stack_t *stack, uint32_t index) {
         return NULL;
     }
 
-    HASH_STACK_ADDRESS(stack, address, stack->size - index)
+    const uint32_t target = stack->size - index;
+    HASH_STACK_PEEK(stack, target, ptr)
+    return ptr;
+}
+
+void *hash_stack_at(hash_stack_t *stack, uint32_t index) {
+    ASSERT_ERROR(stack, TAG, "NULL stack") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(index < stack->size, TAG, "Index must be less than stack size: "
+                                           "size = %d; index = %d", stack->size, index) {
+        return NULL;
+    }
+
+    HASH_STACK_PEEK(stack, index, ptr)
+    return ptr;
+}
+
+void *hash_stack_span(hash_stack_t *stack, uint32_t index, uint32_t *count) {
+    ASSERT_ERROR(stack, TAG, "NULL stack") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(index < stack->size, TAG, "Index must be less than stack size: "
+                                           "size = %d; index = %d", stack->size, index) {
+        return NULL;
+    }
+
+    HASH_STACK_PEEK(stack, index, ptr)
 
-    HASH_STACK_PEEK(stack, address, array)
-    return (void *)array + address * stack->typeSize;
+    if (count) {
+        uint32_t offset, quot;
+        HASH_STACK_DIVMOD(stack, index, quot, offset);
+        *count = MIN(stack->bufferSize - offset, stack->size - index);
+    }
+
+    return ptr;
+}
+
+bool hash_stack_pop_into_n(hash_stack_t *stack, void *dst, uint32_t count) {
+    ASSERT_ERROR(stack, TAG, "NULL stack") {
+        return false;
+    }
+
+    ASSERT_ERROR(dst, TAG, "NULL dst") {
+        return false;
+    }
+
+    ASSERT_ERROR(count <= stack->size, TAG, "Count to pop more than stack size: size = %d, count = %d", stack->size, count) {
+        return false;
+    }
+
+    uint32_t index = stack->size - count;
+    while (index < stack->size) {
+        uint32_t chunk;
+        void *src = hash_stack_span(stack, index, &chunk);
+
+        mem_copy(dst, src, stack->typeSize * chunk);
+
+        dst += stack->typeSize * chunk;
+        index += chunk;
+    }
+
+    stack->size -= count;
+
+    HASH_STACK_AUTO_SHRINK(stack)
+    return true;
 }
 
 uint32_t hash_stack_size(hash_stack_t *stack) {
@@ -236,6 +543,9 @@ void hash_stack_clear_hard(hash_stack_t *stack) {
 
     stack->size = 0;
     stack->levels = 0;
+    stack->leaves = 0;
+    stack->reserved = 0;
+    stack->cap = 0;
     stack->data = NULL;
 }
 
@@ -243,12 +553,10 @@ static void _hash_stack_clear(const alloc_t *alloc, void *data, uint32_t size, u
     void **ptr = data;
     level--;
 
-    if (level == 0) {
-        for (uint32_t i = 0; i < size; i++) {
+    for (uint32_t i = 0; i < size && ptr[i]; i++) {
+        if (level == 0) {
             alloc_free(alloc, ptr[i]);
-        }
-    } else {
-        for (uint32_t i = 0; i < size; i++) {
+        } else {
             _hash_stack_clear(alloc, ptr[i], size, level);
         }
     }
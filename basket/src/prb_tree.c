@@ -0,0 +1,620 @@
+#include "meal/prb_tree.h"
+
+#include "meal/list_pool.h"
+#include "meal/assert.h"
+#include "meal/memory.h"
+
+#include <stdatomic.h>
+
+#define TAG "PRB Tree"
+
+/*Red-black height never exceeds 2 * log2(size + 1)*/
+#define MAX_DEPTH 64
+
+/*Copies made by one update: search path, one sibling per level and the new node*/
+#define RESERVE (2 * MAX_DEPTH + 4)
+
+typedef struct node_t node_t;
+
+typedef enum color {
+    RED,
+    BLACK,
+} color;
+
+/*Nodes have no parent link so that one node can be shared by many versions*/
+/*refs counts parents and roots pointing to the node, it is touched by the writer only*/
+typedef struct node_t {
+    node_t *left;
+    node_t *right;
+    uint32_t refs;
+    uint32_t color;
+    void_t data;
+} node_t;
+
+#define NODE_SIZE(typeSize) ((sizeof(node_t) + (typeSize) + (sizeof(void *) - 1)) & ~(sizeof(void *) - 1))
+
+#define IS_RED(node) ((node) && (node)->color == RED)
+
+typedef struct prb_snapshot_t {
+    prb_tree_t *tree;
+    node_t *root;
+    prb_snapshot_t *next;
+    uint32_t size;
+} prb_snapshot_t;
+
+typedef struct prb_tree_t {
+    const alloc_t *alloc;
+    cmp_f compare;
+    list_pool_t *nodePool;
+    list_pool_t *snapshotPool;
+    _Atomic(prb_snapshot_t *) retired;
+    node_t *root;
+    node_t *spare;
+    uint32_t spareCount;
+    uint32_t nodeSize;
+    uint32_t typeSize;
+    uint32_t size;
+} prb_tree_t;
+
+prb_tree_t *prb_tree_init_via(const alloc_t *alloc, cmp_f compare, uint32_t typeSize, uint32_t bufferSize) {
+    ASSERT_ERROR(compare, TAG, "NULL comparator") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(typeSize, TAG, "TypeSize must be more than 0: typeSize = %d", typeSize) {
+        return NULL;
+    }
+
+    ASSERT_ERROR(bufferSize > 1, TAG, "BufferSize must be more than 1: bufferSize = %d", bufferSize) {
+        return NULL;
+    }
+
+    prb_tree_t *tree = alloc_malloc(alloc, sizeof(prb_tree_t));
+
+    ASSERT_ERROR(tree, TAG, "Can't allocate memory for tree") {
+        return NULL;
+    }
+
+    tree->nodeSize = NODE_SIZE(typeSize);
+    tree->nodePool = list_pool_init_via(alloc, tree->nodeSize, bufferSize);
+
+    ASSERT_ERROR(tree->nodePool, TAG, "Can't allocate memory for pool") {
+        alloc_free(alloc, tree);
+        return NULL;
+    }
+
+    tree->snapshotPool = list_pool_init_via(alloc, sizeof(prb_snapshot_t), bufferSize);
+
+    ASSERT_ERROR(tree->snapshotPool, TAG, "Can't allocate memory for pool") {
+        list_pool_term(tree->nodePool);
+        alloc_free(alloc, tree);
+        return NULL;
+    }
+
+    atomic_init(&tree->retired, NULL);
+    tree->alloc = alloc;
+    tree->compare = compare;
+    tree->root = NULL;
+    tree->spare = NULL;
+    tree->spareCount = 0;
+    tree->typeSize = typeSize;
+    tree->size = 0;
+
+    return tree;
+}
+
+void prb_tree_term(prb_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return;
+    }
+
+    list_pool_term(tree->nodePool);
+    list_pool_term(tree->snapshotPool);
+
+    alloc_free(tree->alloc, tree);
+}
+
+static void _prb_tree_release(prb_tree_t *tree, node_t *node) {
+    while (node && !--node->refs) {
+        _prb_tree_release(tree, node->left);
+        node_t *right = node->right;
+        list_pool_free(tree->nodePool, node);
+        node = right;
+    }
+}
+
+/*Snapshots released by readers are collected here, so node pool stays single threaded*/
+static void _prb_tree_drain(prb_tree_t *tree) {
+    prb_snapshot_t *snapshot = atomic_exchange_explicit(&tree->retired, NULL, memory_order_acquire);
+    while (snapshot) {
+        prb_snapshot_t *next = snapshot->next;
+        _prb_tree_release(tree, snapshot->root);
+        list_pool_free(tree->snapshotPool, snapshot);
+        snapshot = next;
+    }
+}
+
+/*Nodes for one update are taken up front, so it never fails halfway through rebalancing*/
+static bool _prb_tree_reserve(prb_tree_t *tree) {
+    _prb_tree_drain(tree);
+
+    while (tree->spareCount < RESERVE) {
+        node_t *node = list_pool_get(tree->nodePool);
+
+        ASSERT_ERROR(node, TAG, "Can't allocate memory for node") {
+            return false;
+        }
+
+        node->left = tree->spare;
+        tree->spare = node;
+        tree->spareCount++;
+    }
+
+    return true;
+}
+
+static node_t *_prb_tree_node(prb_tree_t *tree) {
+    node_t *node = tree->spare;
+    tree->spare = node->left;
+    tree->spareCount--;
+    return node;
+}
+
+/*Node reachable from writable parent by the only reference is private to the current version*/
+/*Shared node is copied, its children get one more parent*/
+static node_t *_prb_tree_own(prb_tree_t *tree, node_t **slot) {
+    node_t *node = *slot;
+    if (node->refs == 1) {
+        return node;
+    }
+
+    node_t *copy = _prb_tree_node(tree);
+    mem_copy(copy, node, tree->nodeSize);
+    copy->refs = 1;
+    if (copy->left) {
+        copy->left->refs++;
+    }
+    if (copy->right) {
+        copy->right->refs++;
+    }
+
+    node->refs--;
+    *slot = copy;
+    return copy;
+}
+
+static void _prb_tree_rotate_left(node_t **slot) {
+    node_t *node = *slot;
+    node_t *child = node->right;
+
+    node->right = child->left;
+    child->left = node;
+    *slot = child;
+}
+
+static void _prb_tree_rotate_right(node_t **slot) {
+    node_t *node = *slot;
+    node_t *child = node->left;
+
+    node->left = child->right;
+    child->right = node;
+    *slot = child;
+}
+
+/*Owns the search path from root, slots[i] is the link in path[i - 1] pointing to path[i]*/
+static void _prb_tree_own_path(prb_tree_t *tree, const bool *sides, uint32_t depth, node_t **path,
+                               node_t ***slots) {
+    slots[0] = &tree->root;
+    for (uint32_t i = 0; i < depth; i++) {
+        path[i] = _prb_tree_own(tree, slots[i]);
+        slots[i + 1] = sides[i] ? &path[i]->right : &path[i]->left;
+    }
+}
+
+static node_t *_prb_tree_find_node(cmp_f compare, node_t *node, const void *ptr) {
+    while (node) {
+        const int32_t cmpr = compare(ptr, &node->data);
+        if (cmpr < 0) {
+            node = node->left;
+        } else if (cmpr > 0) {
+            node = node->right;
+        } else {
+            break;
+        }
+    }
+    return node;
+}
+
+static void _prb_tree_insert_balance(prb_tree_t *tree, node_t **path, node_t ***slots, uint32_t depth) {
+    while (depth >= 2 && IS_RED(path[depth - 1])) {
+        node_t *node = path[depth];
+        node_t *father = path[depth - 1];
+        node_t *grand = path[depth - 2];
+
+        if (father == grand->left) {
+            if (IS_RED(grand->right)) {
+                _prb_tree_own(tree, &grand->right)->color = BLACK;
+                father->color = BLACK;
+                grand->color = RED;
+                depth -= 2;
+                continue;
+            }
+
+            if (node == father->right) {
+                _prb_tree_rotate_left(slots[depth - 1]);
+                father = node;
+            }
+
+            father->color = BLACK;
+            grand->color = RED;
+            _prb_tree_rotate_right(slots[depth - 2]);
+        } else {
+            if (IS_RED(grand->left)) {
+                _prb_tree_own(tree, &grand->left)->color = BLACK;
+                father->color = BLACK;
+                grand->color = RED;
+                depth -= 2;
+                continue;
+            }
+
+            if (node == father->left) {
+                _prb_tree_rotate_right(slots[depth - 1]);
+                father = node;
+            }
+
+            father->color = BLACK;
+            grand->color = RED;
+            _prb_tree_rotate_left(slots[depth - 2]);
+        }
+        break;
+    }
+}
+
+const void *prb_tree_insert(prb_tree_t *tree, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    bool sides[MAX_DEPTH + 1];
+    uint32_t depth = 0;
+
+    for (node_t *tmp = tree->root; tmp; depth++) {
+        const int32_t cmpr = tree->compare(ptr, &tmp->data);
+        if (!cmpr) {
+            return NULL;
+        }
+        sides[depth] = cmpr > 0;
+        tmp = sides[depth] ? tmp->right : tmp->left;
+    }
+
+    if (!_prb_tree_reserve(tree)) {
+        return NULL;
+    }
+
+    node_t *path[MAX_DEPTH + 1];
+    node_t **slots[MAX_DEPTH + 1];
+    _prb_tree_own_path(tree, sides, depth, path, slots);
+
+    node_t *node = _prb_tree_node(tree);
+    node->left = NULL;
+    node->right = NULL;
+    node->refs = 1;
+    node->color = RED;
+    mem_copy(&node->data, ptr, tree->typeSize);
+
+    *slots[depth] = node;
+    path[depth] = node;
+
+    _prb_tree_insert_balance(tree, path, slots, depth);
+    tree->root->color = BLACK;
+    tree->size++;
+
+    return &node->data;
+}
+
+const void *prb_tree_find(prb_tree_t *tree, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    node_t *node = _prb_tree_find_node(tree->compare, tree->root, ptr);
+    return node ? &node->data : NULL;
+}
+
+/*Double black sits at path[depth], which may be NULL; it is pushed up or absorbed by rotations*/
+static void _prb_tree_remove_balance(prb_tree_t *tree, node_t **path, node_t ***slots, uint32_t depth) {
+    node_t *node = *slots[depth];
+
+    while (depth && !IS_RED(node)) {
+        node_t *father = path[depth - 1];
+        node_t **fatherSlot = slots[depth - 1];
+
+        if (slots[depth] == &father->left) {
+            node_t *brother = _prb_tree_own(tree, &father->right);
+
+            if (brother->color == RED) {
+                brother->color = BLACK;
+                father->color = RED;
+                _prb_tree_rotate_left(fatherSlot);
+                fatherSlot = &brother->left;
+                brother = _prb_tree_own(tree, &father->right);
+            }
+
+            if (!IS_RED(brother->left) && !IS_RED(brother->right)) {
+                brother->color = RED;
+                node = father;
+                depth--;
+                continue;
+            }
+
+            if (!IS_RED(brother->right)) {
+                _prb_tree_own(tree, &brother->left)->color = BLACK;
+                brother->color = RED;
+                _prb_tree_rotate_right(&father->right);
+                brother = father->right;
+            }
+
+            brother->color = father->color;
+            father->color = BLACK;
+            _prb_tree_own(tree, &brother->right)->color = BLACK;
+            _prb_tree_rotate_left(fatherSlot);
+        } else {
+            node_t *brother = _prb_tree_own(tree, &father->left);
+
+            if (brother->color == RED) {
+                brother->color = BLACK;
+                father->color = RED;
+                _prb_tree_rotate_right(fatherSlot);
+                fatherSlot = &brother->right;
+                brother = _prb_tree_own(tree, &father->left);
+            }
+
+            if (!IS_RED(brother->left) && !IS_RED(brother->right)) {
+                brother->color = RED;
+                node = father;
+                depth--;
+                continue;
+            }
+
+            if (!IS_RED(brother->left)) {
+                _prb_tree_own(tree, &brother->right)->color = BLACK;
+                brother->color = RED;
+                _prb_tree_rotate_left(&father->left);
+                brother = father->left;
+            }
+
+            brother->color = father->color;
+            father->color = BLACK;
+            _prb_tree_own(tree, &brother->left)->color = BLACK;
+            _prb_tree_rotate_right(fatherSlot);
+        }
+        return;
+    }
+
+    if (IS_RED(node)) {
+        node->color = BLACK;
+    }
+}
+
+bool prb_tree_remove(prb_tree_t *tree, const void *ptr, void *dst) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return false;
+    }
+
+    bool sides[MAX_DEPTH + 1];
+    uint32_t depth = 0;
+    node_t *target = tree->root;
+
+    while (target) {
+        const int32_t cmpr = tree->compare(ptr, &target->data);
+        if (!cmpr) {
+            break;
+        }
+        sides[depth++] = cmpr > 0;
+        target = sides[depth - 1] ? target->right : target->left;
+    }
+
+    if (!target) {
+        return false;
+    }
+
+    if (!_prb_tree_reserve(tree)) {
+        return false;
+    }
+
+    if (dst) {
+        mem_copy(dst, &target->data, tree->typeSize);
+    }
+
+    const uint32_t targetDepth = depth;
+    if (target->left && target->right) {
+        sides[depth++] = true;
+        for (node_t *tmp = target->right; tmp->left; tmp = tmp->left) {
+            sides[depth++] = false;
+        }
+    }
+
+    node_t *path[MAX_DEPTH + 1];
+    node_t **slots[MAX_DEPTH + 1];
+    _prb_tree_own_path(tree, sides, depth, path, slots);
+    node_t *node = path[depth] = _prb_tree_own(tree, slots[depth]);
+
+    /*Successor data moves into the private copy of target, successor node is unlinked instead*/
+    if (depth != targetDepth) {
+        mem_copy(&path[targetDepth]->data, &node->data, tree->typeSize);
+    }
+
+    node_t *child = node->left ? node->left : node->right;
+    const color removed = node->color;
+    *slots[depth] = child;
+    list_pool_free(tree->nodePool, node);
+
+    if (removed == BLACK) {
+        if (IS_RED(child)) {
+            _prb_tree_own(tree, slots[depth])->color = BLACK;
+        } else {
+            _prb_tree_remove_balance(tree, path, slots, depth);
+        }
+    }
+
+    tree->size--;
+    return true;
+}
+
+static void _prb_tree_foreach(node_t *node, const_action_f func, void *data) {
+    while (node) {
+        _prb_tree_foreach(node->left, func, data);
+        func(&node->data, data);
+        node = node->right;
+    }
+}
+
+void prb_tree_foreach(prb_tree_t *tree, const_action_f func, void *data) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return;
+    }
+
+    ASSERT_ERROR(func, TAG, "NULL function") {
+        return;
+    }
+
+    _prb_tree_foreach(tree->root, func, data);
+}
+
+uint32_t prb_tree_size(prb_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return 0;
+    }
+
+    return tree->size;
+}
+
+prb_snapshot_t *prb_tree_snapshot(prb_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    _prb_tree_drain(tree);
+
+    prb_snapshot_t *snapshot = list_pool_get(tree->snapshotPool);
+
+    ASSERT_ERROR(snapshot, TAG, "Can't allocate memory for snapshot") {
+        return NULL;
+    }
+
+    snapshot->tree = tree;
+    snapshot->root = tree->root;
+    snapshot->next = NULL;
+    snapshot->size = tree->size;
+    if (tree->root) {
+        tree->root->refs++;
+    }
+
+    return snapshot;
+}
+
+const void *prb_snapshot_find(prb_snapshot_t *snapshot, const void *ptr) {
+    ASSERT_ERROR(snapshot, TAG, "NULL snapshot") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    node_t *node = _prb_tree_find_node(snapshot->tree->compare, snapshot->root, ptr);
+    return node ? &node->data : NULL;
+}
+
+const void *prb_snapshot_min(prb_snapshot_t *snapshot, const void *ptr) {
+    ASSERT_ERROR(snapshot, TAG, "NULL snapshot") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    node_t *node = snapshot->root;
+    node_t *result = NULL;
+    while (node) {
+        const int32_t cmpr = snapshot->tree->compare(ptr, &node->data);
+        if (cmpr < 0) {
+            result = node;
+            node = node->left;
+        } else if (cmpr > 0) {
+            node = node->right;
+        } else {
+            return &node->data;
+        }
+    }
+    return result ? &result->data : NULL;
+}
+
+const void *prb_snapshot_max(prb_snapshot_t *snapshot, const void *ptr) {
+    ASSERT_ERROR(snapshot, TAG, "NULL snapshot") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    node_t *node = snapshot->root;
+    node_t *result = NULL;
+    while (node) {
+        const int32_t cmpr = snapshot->tree->compare(ptr, &node->data);
+        if (cmpr < 0) {
+            node = node->left;
+        } else if (cmpr > 0) {
+            result = node;
+            node = node->right;
+        } else {
+            return &node->data;
+        }
+    }
+    return result ? &result->data : NULL;
+}
+
+void prb_snapshot_foreach(prb_snapshot_t *snapshot, const_action_f func, void *data) {
+    ASSERT_ERROR(snapshot, TAG, "NULL snapshot") {
+        return;
+    }
+
+    ASSERT_ERROR(func, TAG, "NULL function") {
+        return;
+    }
+
+    _prb_tree_foreach(snapshot->root, func, data);
+}
+
+uint32_t prb_snapshot_size(prb_snapshot_t *snapshot) {
+    ASSERT_ERROR(snapshot, TAG, "NULL snapshot") {
+        return 0;
+    }
+
+    return snapshot->size;
+}
+
+void prb_snapshot_release(prb_snapshot_t *snapshot) {
+    ASSERT_ERROR(snapshot, TAG, "NULL snapshot") {
+        return;
+    }
+
+    prb_tree_t *tree = snapshot->tree;
+    snapshot->next = atomic_load_explicit(&tree->retired, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&tree->retired, &snapshot->next, snapshot,
+                                                  memory_order_release, memory_order_relaxed));
+}
@@ -0,0 +1,272 @@
+#ifndef MEAL_BASKET_RB_BALANCE_H
+#define MEAL_BASKET_RB_BALANCE_H
+
+/*Red-black balancing shared by rb_tree and rb_link. The including file defines:*/
+/*RB_NODE_T - node type starting with parentColor, left and right*/
+/*RB_OWNER_T - what holds the root, RB_ROOT(owner) is the root lvalue*/
+/*RB_ROTATED(owner, child, node) - child took the place of node in a rotation*/
+/*RB_PATH_SHRUNK(owner, node) - node and its ancestors lost one descendant*/
+/*RB_REPLACED(owner, donor, target) - donor took the place of target*/
+/*RB_LINK_STORE(owner, link, node) - optional, see below*/
+
+#include <stdint.h>
+
+typedef enum color {
+    RED,
+    BLACK,
+} color;
+
+/*Nodes are at least pointer aligned, so color is kept in the low bit of parent*/
+#define PARENT(node) ((RB_NODE_T *)((node)->parentColor & ~(uintptr_t)1))
+
+#define COLOR(node) ((color)((node)->parentColor & 1))
+
+#define SET_PARENT(node, parent) ((node)->parentColor = (uintptr_t)(parent) | ((node)->parentColor & 1))
+
+#define SET_COLOR(node, _color) ((node)->parentColor = ((node)->parentColor & ~(uintptr_t)1) | (_color))
+
+#define IS_RED(node) ((node) && COLOR(node) == RED)
+
+/*Every link write goes through RB_LINK_STORE(owner, link, node), a plain store unless*/
+/*the includer defines it, rb_tree.c does so for trees read while they are relinked*/
+#ifndef RB_LINK_STORE
+#define RB_LINK_STORE(owner, link, node) ((link) = (node))
+#endif
+
+#define TO_ROOT(owner, node)\
+do {\
+    RB_LINK_STORE(owner, RB_ROOT(owner), node);\
+    if (node) {\
+        SET_PARENT(node, NULL);\
+    }\
+} while(0)
+
+#define TO_SIDE(owner, father, side, node)\
+do {\
+    RB_LINK_STORE(owner, father->side, node);\
+    if (node) {\
+        SET_PARENT(node, father);\
+    }\
+} while(0)
+
+#define TO_PARENT(owner, father, old, node)\
+do {\
+    if (!father) {\
+        TO_ROOT(owner, node);\
+    } else if (father->left == old) {\
+        TO_SIDE(owner, father, left, node);\
+    } else {\
+        TO_SIDE(owner, father, right, node);\
+    }\
+} while(0)
+
+static void _rb_balance_rotate_left(RB_OWNER_T *owner, RB_NODE_T *node) {
+    RB_NODE_T *child = node->right;
+    RB_NODE_T *father = PARENT(node);
+
+    TO_SIDE(owner, node, right, child->left);
+    TO_PARENT(owner, father, node, child);
+    TO_SIDE(owner, child, left, node);
+
+    RB_ROTATED(owner, child, node);
+}
+
+static void _rb_balance_rotate_right(RB_OWNER_T *owner, RB_NODE_T *node) {
+    RB_NODE_T *child = node->left;
+    RB_NODE_T *father = PARENT(node);
+
+    TO_SIDE(owner, node, left, child->right);
+    TO_PARENT(owner, father, node, child);
+    TO_SIDE(owner, child, right, node);
+
+    RB_ROTATED(owner, child, node);
+}
+
+/*Node is already linked in red*/
+static void _rb_balance_insert(RB_OWNER_T *owner, RB_NODE_T *node) {
+    RB_NODE_T *father;
+    while ((father = PARENT(node)) && COLOR(father) == RED) {
+        /*Red father is never root, so grand exists*/
+        RB_NODE_T *grand = PARENT(father);
+
+        if (father == grand->left) {
+            RB_NODE_T *uncle = grand->right;
+
+            if (IS_RED(uncle)) {
+                SET_COLOR(father, BLACK);
+                SET_COLOR(uncle, BLACK);
+                SET_COLOR(grand, RED);
+                node = grand;
+                continue;
+            }
+
+            if (node == father->right) {
+                _rb_balance_rotate_left(owner, father);
+                node = father;
+                father = PARENT(node);
+            }
+
+            SET_COLOR(father, BLACK);
+            SET_COLOR(grand, RED);
+            _rb_balance_rotate_right(owner, grand);
+        } else {
+            RB_NODE_T *uncle = grand->left;
+
+            if (IS_RED(uncle)) {
+                SET_COLOR(father, BLACK);
+                SET_COLOR(uncle, BLACK);
+                SET_COLOR(grand, RED);
+                node = grand;
+                continue;
+            }
+
+            if (node == father->left) {
+                _rb_balance_rotate_right(owner, father);
+                node = father;
+                father = PARENT(node);
+            }
+
+            SET_COLOR(father, BLACK);
+            SET_COLOR(grand, RED);
+            _rb_balance_rotate_left(owner, grand);
+        }
+    }
+
+    SET_COLOR(RB_ROOT(owner), BLACK);
+}
+
+/*Node took the place of a removed black one and is short of one black, father is its parent*/
+static void _rb_balance_remove(RB_OWNER_T *owner, RB_NODE_T *node, RB_NODE_T *father) {
+    while (node != RB_ROOT(owner) && !IS_RED(node)) {
+        if (node == father->left) {
+            RB_NODE_T *brother = father->right;
+
+            if (COLOR(brother) == RED) {
+                SET_COLOR(brother, BLACK);
+                SET_COLOR(father, RED);
+                _rb_balance_rotate_left(owner, father);
+                brother = father->right;
+            }
+
+            if (!IS_RED(brother->left) && !IS_RED(brother->right)) {
+                SET_COLOR(brother, RED);
+                node = father;
+                father = PARENT(node);
+                continue;
+            }
+
+            if (!IS_RED(brother->right)) {
+                SET_COLOR(brother->left, BLACK);
+                SET_COLOR(brother, RED);
+                _rb_balance_rotate_right(owner, brother);
+                brother = father->right;
+            }
+
+            SET_COLOR(brother, COLOR(father));
+            SET_COLOR(father, BLACK);
+            SET_COLOR(brother->right, BLACK);
+            _rb_balance_rotate_left(owner, father);
+        } else {
+            RB_NODE_T *brother = father->left;
+
+            if (COLOR(brother) == RED) {
+                SET_COLOR(brother, BLACK);
+                SET_COLOR(father, RED);
+                _rb_balance_rotate_right(owner, father);
+                brother = father->left;
+            }
+
+            if (!IS_RED(brother->left) && !IS_RED(brother->right)) {
+                SET_COLOR(brother, RED);
+                node = father;
+                father = PARENT(node);
+                continue;
+            }
+
+            if (!IS_RED(brother->left)) {
+                SET_COLOR(brother->right, BLACK);
+                SET_COLOR(brother, RED);
+                _rb_balance_rotate_left(owner, brother);
+                brother = father->left;
+            }
+
+            SET_COLOR(brother, COLOR(father));
+            SET_COLOR(father, BLACK);
+            SET_COLOR(brother->left, BLACK);
+            _rb_balance_rotate_right(owner, father);
+        }
+        break;
+    }
+
+    if (node) {
+        SET_COLOR(node, BLACK);
+    }
+}
+
+/*Nodes are relinked, never copied, so pointers into the other nodes stay valid*/
+static void _rb_balance_unlink(RB_OWNER_T *owner, RB_NODE_T *target) {
+    RB_NODE_T *child;
+    RB_NODE_T *father;
+    color removed;
+
+    if (!target->left || !target->right) {
+        child = target->left ? target->left : target->right;
+        father = PARENT(target);
+        removed = COLOR(target);
+
+        RB_PATH_SHRUNK(owner, father);
+
+        TO_PARENT(owner, father, target, child);
+    } else {
+        /*Target has two children, donor takes its place and color*/
+        RB_NODE_T *donor = target->right;
+        while (donor->left) {
+            donor = donor->left;
+        }
+
+        child = donor->right;
+        removed = COLOR(donor);
+
+        /*Path from donor's place passes through target*/
+        RB_PATH_SHRUNK(owner, PARENT(donor));
+        RB_REPLACED(owner, donor, target);
+
+        if (PARENT(donor) == target) {
+            father = donor;
+        } else {
+            father = PARENT(donor);
+            TO_SIDE(owner, father, left, child);
+            TO_SIDE(owner, donor, right, target->right);
+        }
+
+        TO_PARENT(owner, PARENT(target), target, donor);
+        TO_SIDE(owner, donor, left, target->left);
+        SET_COLOR(donor, COLOR(target));
+    }
+
+    if (removed == BLACK) {
+        _rb_balance_remove(owner, child, father);
+    }
+}
+
+/*Black height of subtree, or -1 when a parent link, red-red edge or black height is broken, O(n)*/
+static int32_t _rb_balance_check(RB_NODE_T *node, RB_NODE_T *father) {
+    if (!node) {
+        return 0;
+    }
+
+    if (PARENT(node) != father || (IS_RED(node) && (IS_RED(node->left) || IS_RED(node->right)))) {
+        return -1;
+    }
+
+    const int32_t left = _rb_balance_check(node->left, node);
+    const int32_t right = _rb_balance_check(node->right, node);
+
+    if (left < 0 || left != right) {
+        return -1;
+    }
+
+    return left + (COLOR(node) == BLACK);
+}
+
+#endif //MEAL_BASKET_RB_BALANCE_H
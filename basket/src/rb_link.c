@@ -0,0 +1,88 @@
+#include "meal/rb_link.h"
+
+#include "meal/assert.h"
+
+#define TAG "RB Link"
+
+#define RB_NODE_T rb_link_t
+
+#define RB_OWNER_T rb_link_t *
+
+#define RB_ROOT(root) (*(root))
+
+#define RB_ROTATED(root, child, node)
+
+#define RB_PATH_SHRUNK(root, node)
+
+#define RB_REPLACED(root, donor, target)
+
+#include "rb_balance.h"
+
+void rb_link_insert(rb_link_t **root, rb_link_t *node, rb_link_t *parent, rb_link_t **slot) {
+    ASSERT_ERROR(root && node && slot, TAG, "NULL link") {
+        return;
+    }
+
+    node->parentColor = (uintptr_t)parent | RED;
+    node->left = NULL;
+    node->right = NULL;
+    *slot = node;
+
+    _rb_balance_insert(root, node);
+}
+
+void rb_link_erase(rb_link_t **root, rb_link_t *node) {
+    ASSERT_ERROR(root && node, TAG, "NULL link") {
+        return;
+    }
+
+    _rb_balance_unlink(root, node);
+}
+
+rb_link_t *rb_link_first(rb_link_t *root) {
+    while (root && root->left) {
+        root = root->left;
+    }
+    return root;
+}
+
+rb_link_t *rb_link_last(rb_link_t *root) {
+    while (root && root->right) {
+        root = root->right;
+    }
+    return root;
+}
+
+rb_link_t *rb_link_next(rb_link_t *node) {
+    ASSERT_ERROR(node, TAG, "NULL link") {
+        return NULL;
+    }
+
+    if (node->right) {
+        return rb_link_first(node->right);
+    }
+
+    while (PARENT(node) && PARENT(node)->right == node) {
+        node = PARENT(node);
+    }
+    return PARENT(node);
+}
+
+rb_link_t *rb_link_prev(rb_link_t *node) {
+    ASSERT_ERROR(node, TAG, "NULL link") {
+        return NULL;
+    }
+
+    if (node->left) {
+        return rb_link_last(node->left);
+    }
+
+    while (PARENT(node) && PARENT(node)->left == node) {
+        node = PARENT(node);
+    }
+    return PARENT(node);
+}
+
+bool rb_link_check(rb_link_t *root) {
+    return (!root || COLOR(root) == BLACK) && _rb_balance_check(root, NULL) >= 0;
+}
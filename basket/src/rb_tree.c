@@ -5,8 +5,12 @@
 #include "meal/memory.h"
 #include "meal/macros.h"
 #include "meal/math.h"
+#include "rb_tree.h"
 #include "iter.h"
 
+#include <stdatomic.h>
+#include <pthread.h>
+
 #define TAG "RB Tree"
 
 typedef struct node_t node_t;
@@ -17,14 +21,8 @@ typedef enum stackFlag {
     WAS_RIGHT,
 } stackFlag;
 
-typedef enum color {
-    RED,
-    BLACK,
-} color;
-
 typedef struct node_t {
-    color color;
-    node_t *parent;
+    uintptr_t parentColor;
     node_t *left;
     node_t *right;
     void_t data;
@@ -32,24 +30,106 @@ typedef struct node_t {
 
 #define NODE(ptr) ((node_t *)ptr)
 
+#define NODE_SIZE(typeSize) ((sizeof(node_t) + (typeSize) + (sizeof(void *) - 1)) & ~(sizeof(void *) - 1))
+
 typedef struct rb_tree_t {
     const alloc_t *alloc;
     cmp_f compare;
     list_pool_t *nodePool;
     list_pool_t *iterPool;
+    uint32_t *poolRefs;
+    action_f retire;
+    void *retireData;
     node_t *root;
+    node_t *first;
+    node_t *last;
     uint32_t typeSize;
+    uint32_t nodeSize;
+    uint32_t bufferSize;
     uint32_t size;
+    uint32_t countOffset;
 } rb_tree_t;
 
+/*Ranked trees keep subtree size right after node data, countOffset is 0 otherwise*/
+#define COUNT(tree, node) (*(uint32_t *)((void *)(node) + (tree)->countOffset))
+
+#define SUBTREE_COUNT(tree, node) ((node) ? COUNT(tree, node) : 0)
+
+#define UPDATE_COUNT(tree, node) (COUNT(tree, node) = SUBTREE_COUNT(tree, node->left) + SUBTREE_COUNT(tree, node->right) + 1)
+
+/*COUNT of a plain tree would read element data, so unlike ASSERT_ERROR this stays in release builds*/
+#define RANKED_OR_RETURN(tree, result)\
+do {\
+    if (!(tree)->countOffset) {\
+        log_error(TAG, "Tree is not ranked");\
+        return result;\
+    }\
+} while (0)
+
+static void _rb_tree_count_path(rb_tree_t *tree, node_t *node, int32_t diff);
+
+#define RB_NODE_T node_t
+
+#define RB_OWNER_T rb_tree_t
+
+#define RB_ROOT(tree) ((tree)->root)
+
+#define RB_ROTATED(tree, child, node)\
+do {\
+    if ((tree)->countOffset) {\
+        COUNT(tree, child) = COUNT(tree, node);\
+        UPDATE_COUNT(tree, node);\
+    }\
+} while (0)
+
+#define RB_PATH_SHRUNK(tree, node) _rb_tree_count_path(tree, node, -1)
+
+#define RB_REPLACED(tree, donor, target)\
+do {\
+    if ((tree)->countOffset) {\
+        COUNT(tree, donor) = COUNT(tree, target);\
+    }\
+} while (0)
+
+/*crb_tree lookups walk the links while its writer relinks them, so for trees with a retire action*/
+/*links are stored with release and loaded with acquire: a reader that reaches a node sees its data*/
+#if defined(__GNUC__)
+#define RB_LINK_STORE(tree, link, node)\
+do {\
+    if ((tree)->retire) {\
+        __atomic_store_n(&(link), node, __ATOMIC_RELEASE);\
+    } else {\
+        (link) = (node);\
+    }\
+} while (0)
+
+#define LINK_LOAD(link) __atomic_load_n(&(link), __ATOMIC_ACQUIRE)
+#else
+#define LINK_LOAD(link) (link)
+#endif
+
+#include "rb_balance.h"
+
+/*Unlinked nodes go to retire instead of the pool while somebody may still read them*/
+#define FREE_NODE(tree, node)\
+do {\
+    if ((tree)->retire) {\
+        (tree)->retire(node, (tree)->retireData);\
+    } else {\
+        list_pool_free((tree)->nodePool, node);\
+    }\
+} while (0)
+
 typedef struct iter_box_t {
     list_pool_t *pool;
     node_t *node;
 } iter_box_t;
 
-#define ITER(ptr) ((iter_box_t *)ptr)
+/*Box lives in pool memory right after the iter_t header, addressed from it rather than punned from data*/
+#define ITER(iter) ((iter_box_t *)((void *)(iter) + sizeof(iter_t)))
 
-rb_tree_t *rb_tree_init_via(const alloc_t *alloc, cmp_f compare, size_t typeSize, size_t bufferSize) {
+static rb_tree_t *_rb_tree_init(const alloc_t *alloc, cmp_f compare, uint32_t typeSize, uint32_t bufferSize,
+                                bool ranked) {
     ASSERT_ERROR(compare, TAG, "NULL comparator") {
         return NULL;
     }
@@ -70,7 +150,11 @@ rb_tree_t *rb_tree_init_via(const alloc_t *alloc, cmp_f compare, size_t typeSize
 
     tree->alloc = alloc;
     tree->compare = compare;
-    tree->nodePool = list_pool_init_via(alloc, sizeof(node_t) + typeSize, bufferSize);
+    tree->countOffset = ranked ? sizeof(node_t) + ((typeSize + (sizeof(uint32_t) - 1)) & ~(sizeof(uint32_t) - 1)) : 0;
+
+    tree->nodeSize = ranked ? NODE_SIZE(tree->countOffset - sizeof(node_t) + sizeof(uint32_t)) : NODE_SIZE(typeSize);
+    tree->bufferSize = bufferSize;
+    tree->nodePool = list_pool_init_via(alloc, tree->nodeSize, bufferSize);
 
     ASSERT_ERROR(tree->nodePool, TAG, "Can't allocate memory for pool") {
         alloc_free(alloc, tree);
@@ -85,20 +169,79 @@ rb_tree_t *rb_tree_init_via(const alloc_t *alloc, cmp_f compare, size_t typeSize
         return NULL;
     }
 
+    tree->poolRefs = NULL;
+    tree->retire = NULL;
+    tree->retireData = NULL;
     tree->root = NULL;
+    tree->first = NULL;
+    tree->last = NULL;
     tree->typeSize = typeSize;
     tree->size = 0;
 
-
     return tree;
 }
 
+rb_tree_t *rb_tree_init_via(const alloc_t *alloc, cmp_f compare, uint32_t typeSize, uint32_t bufferSize) {
+    return _rb_tree_init(alloc, compare, typeSize, bufferSize, false);
+}
+
+rb_tree_t *rb_tree_init_ranked_via(const alloc_t *alloc, cmp_f compare, uint32_t typeSize, uint32_t bufferSize) {
+    return _rb_tree_init(alloc, compare, typeSize, bufferSize, true);
+}
+
+/*Siblings share one node pool, so nodes can be moved between them by relinking only*/
+rb_tree_t *rb_tree_init_sibling(rb_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    if (!tree->poolRefs) {
+        tree->poolRefs = alloc_malloc(tree->alloc, sizeof(uint32_t));
+
+        ASSERT_ERROR(tree->poolRefs, TAG, "Can't allocate memory for pool refs") {
+            return NULL;
+        }
+
+        *tree->poolRefs = 1;
+    }
+
+    rb_tree_t *sibling = alloc_malloc(tree->alloc, sizeof(rb_tree_t));
+
+    ASSERT_ERROR(sibling, TAG, "Can't allocate memory for tree") {
+        return NULL;
+    }
+
+    *sibling = *tree;
+    sibling->iterPool = list_pool_init_via(tree->alloc, sizeof(iter_t) + sizeof(iter_box_t), tree->bufferSize);
+
+    ASSERT_ERROR(sibling->iterPool, TAG, "Can't allocate memory for pool") {
+        alloc_free(tree->alloc, sibling);
+        return NULL;
+    }
+
+    sibling->root = NULL;
+    sibling->first = NULL;
+    sibling->last = NULL;
+    sibling->size = 0;
+    (*tree->poolRefs)++;
+
+    return sibling;
+}
+
+static uint32_t _rb_tree_free_nodes(rb_tree_t *tree, node_t *node);
+
 void rb_tree_term(rb_tree_t *tree) {
     ASSERT_ERROR(tree, TAG, "NULL tree") {
         return;
     }
 
-    list_pool_term(tree->nodePool);
+    if (tree->poolRefs && --*tree->poolRefs) {
+        _rb_tree_free_nodes(tree, tree->root);
+    } else {
+        alloc_free(tree->alloc, tree->poolRefs);
+        list_pool_term(tree->nodePool);
+    }
+    list_pool_term(tree->iterPool);
 
     alloc_free(tree->alloc, tree);
 }
@@ -110,25 +253,13 @@ do {\
         return NULL;\
     }\
     \
-    node->parent = NULL;\
+    node->parentColor = RED;\
     node->left = NULL;\
     node->right = NULL;\
     \
     mem_copy(&node->data, ptr, tree->typeSize);\
 } while (0)
 
-#define TO_ROOT(tree, node)\
-do {\
-    tree->root = node;\
-    node && (node->parent = NULL);\
-} while(0)
-
-#define TO_SIDE(father, side, node)\
-do {\
-    father->side = node;\
-    node && (node->parent = father);\
-} while(0)
-
 
 #define NEXT(node) \
 do {\
@@ -138,10 +269,10 @@ do {\
             node = node->left;\
         }\
     } else {\
-        while (node->parent && node->parent->right == node) {\
-            node = node->parent;\
+        while (PARENT(node) && PARENT(node)->right == node) {\
+            node = PARENT(node);\
         }\
-        node = node->parent;\
+        node = PARENT(node);\
     }\
 } while(0)
 
@@ -153,32 +284,32 @@ do {\
             node = node->right;\
         }\
     } else {\
-        while (node->parent && node->parent->left == node) {\
-            node = node->parent;\
+        while (PARENT(node) && PARENT(node)->left == node) {\
+            node = PARENT(node);\
         }\
-        node = node->parent;\
+        node = PARENT(node);\
     }\
 } while (0)
 
 static void _rb_tree_iter_next(iter_t *iter) {
-    if (ITER(&iter->data)->node) {
-        NEXT(ITER(&iter->data)->node);
+    if (ITER(iter)->node) {
+        NEXT(ITER(iter)->node);
     }
 }
 static void _rb_tree_iter_prev(iter_t *iter) {
-    if (ITER(&iter->data)->node) {
-        PREV(ITER(&iter->data)->node);
+    if (ITER(iter)->node) {
+        PREV(ITER(iter)->node);
     }
 }
 
 static void *_rb_tree_iter_value(iter_t *iter) {
-    return ITER(&iter->data)->node ? &ITER(&iter->data)->node->data : NULL;
+    return ITER(iter)->node ? &ITER(iter)->node->data : NULL;
 }
 
 static iter_t *_rb_tree_iter_copy(iter_t *iter);
 
 static void _rb_tree_iter_term(iter_t *iter) {
-    list_pool_free(ITER(&iter->data)->pool, iter);
+    list_pool_free(ITER(iter)->pool, iter);
 }
 
 static const iter_funcs_t _iter_funcs = {
@@ -196,66 +327,202 @@ do {\
         return NULL;\
     }\
     iter->funcs = &_iter_funcs;\
-    ITER(&iter->data)->pool = _pool;\
-    ITER(&iter->data)->node = _node;\
+    ITER(iter)->pool = _pool;\
+    ITER(iter)->node = _node;\
 } while (0)
 
 static iter_t *_rb_tree_iter_copy(iter_t *iter) {
     iter_t *newIter;
-    CREATE_ITER(newIter, ITER(&iter->data)->pool, ITER(&iter->data)->node);
+    CREATE_ITER(newIter, ITER(iter)->pool, ITER(iter)->node);
     return newIter;
 }
 
-iter_t *rb_tree_iter_tmp(rb_tree_t *tree, const void *ptr) {
+static node_t *_rb_tree_find_node(rb_tree_t *tree, const void *ptr) {
+    node_t *tmp = tree->root;
+    while (tmp) {
+        int32_t cmpr = tree->compare(ptr, &tmp->data);
+        if (cmpr < 0) {
+            tmp = tmp->left;
+        } else if (cmpr > 0) {
+            tmp = tmp->right;
+        } else {
+            return tmp;
+        }
+    }
 
+    return NULL;
 }
 
-#define RB_TREE_INSERT_BALANCE(tree, target) \
-while (target->color == RED) {\
-    if (!target->parent) {\
-        target->color = BLACK;\
-        return NULL;\
-    }\
-\
-    node_t *father = target->parent;\
-    node_t *brother = (node_t *) FTERNP(father->left == target, father->right, father->left);\
-\
-    if (!brother || brother->color == BLACK) {\
-        node_t *grand = father->parent;\
-        \
-        if (father->left == target) {\
-            TO_SIDE(father, left, target->right);\
-            TO_SIDE(target, right, father);\
-        } else {\
-            TO_SIDE(father, right, target->left);\
-            TO_SIDE(target, left, father);\
-        }\
-\
-        father->color = RED;\
-        target->color = BLACK;\
-\
-        if (grand) {\
-            if (grand->left == father) {\
-                TO_SIDE(grand, left, target);\
-            } else {\
-                TO_SIDE(grand, right, target);\
-            }\
-        } else {\
-            TO_ROOT(tree, target);\
-        }\
-        break;\
+static node_t *_rb_tree_min_node(rb_tree_t *tree, const void *ptr) {
+    node_t *tmp = tree->root;
+    node_t *result = NULL;
+    while (tmp) {
+        int32_t cmpr = tree->compare(ptr, &tmp->data);
+        if (cmpr < 0) {
+            result = tmp;
+            tmp = tmp->left;
+        } else if (cmpr > 0) {
+            tmp = tmp->right;
+        } else {
+            return tmp;
+        }
+    }
+
+    return result;
+}
+
+static node_t *_rb_tree_max_node(rb_tree_t *tree, const void *ptr) {
+    node_t *tmp = tree->root;
+    node_t *result = NULL;
+    while (tmp) {
+        int32_t cmpr = tree->compare(ptr, &tmp->data);
+        if (cmpr < 0) {
+            tmp = tmp->left;
+        } else if (cmpr > 0) {
+            result = tmp;
+            tmp = tmp->right;
+        } else {
+            return tmp;
+        }
+    }
+
+    return result;
+}
+
+#define ITER_TMP(iter, _node) ((iter)->node = _node, (_node) ? &NODE(_node)->data : NULL)
+
+void *rb_tree_iter_tmp(rb_tree_t *tree, const void *ptr, rb_tree_iter_s *iter) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    node_t *node = _rb_tree_find_node(tree, ptr);
+    return ITER_TMP(iter, node);
+}
+
+void *rb_tree_begin_iter_tmp(rb_tree_t *tree, rb_tree_iter_s *iter) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    node_t *node = tree->first;
+    return ITER_TMP(iter, node);
+}
+
+void *rb_tree_min_iter_tmp(rb_tree_t *tree, const void *ptr, rb_tree_iter_s *iter) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    node_t *node = _rb_tree_min_node(tree, ptr);
+    return ITER_TMP(iter, node);
+}
+
+void *rb_tree_max_iter_tmp(rb_tree_t *tree, const void *ptr, rb_tree_iter_s *iter) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    node_t *node = _rb_tree_max_node(tree, ptr);
+    return ITER_TMP(iter, node);
+}
+
+void *rb_tree_iter_tmp_next(rb_tree_iter_s *iter) {
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    node_t *node = iter->node;
+    if (node) {
+        NEXT(node);
+    }
+
+    return ITER_TMP(iter, node);
+}
+
+void *rb_tree_iter_tmp_prev(rb_tree_iter_s *iter) {
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    node_t *node = iter->node;
+    if (node) {
+        PREV(node);
+    }
+
+    return ITER_TMP(iter, node);
+}
+
+void *rb_tree_iter_tmp_value(const rb_tree_iter_s *iter) {
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    return iter->node ? &NODE(iter->node)->data : NULL;
+}
+
+static void _rb_tree_bounds(rb_tree_t *tree) {
+    tree->first = tree->root;
+    while (tree->first && tree->first->left) {
+        tree->first = tree->first->left;
+    }
+
+    tree->last = tree->root;
+    while (tree->last && tree->last->right) {
+        tree->last = tree->last->right;
+    }
+}
+
+static void _rb_tree_count_path(rb_tree_t *tree, node_t *node, int32_t diff) {
+    if (tree->countOffset) {
+        for (; node; node = PARENT(node)) {
+            COUNT(tree, node) += diff;
+        }
+    }
+}
+
+#define RB_TREE_INSERT_BALANCE(tree, node)\
+do {\
+    if (PARENT(node) == tree->first && PARENT(node)->left == node) {\
+        tree->first = node;\
+    } else if (PARENT(node) == tree->last && PARENT(node)->right == node) {\
+        tree->last = node;\
     }\
-\
-    target->color = BLACK;\
-    brother->color = BLACK;\
-\
-    if (father->parent) {\
-        father->color = RED;\
-        target = father->parent;\
-    } else {\
-        break;\
+    \
+    if (tree->countOffset) {\
+        COUNT(tree, node) = 0;\
+        _rb_tree_count_path(tree, node, 1);\
     }\
-}
+    _rb_balance_insert(tree, node);\
+} while (0)
 
 void *rb_tree_insert(rb_tree_t *tree, const void *ptr) {
     ASSERT_ERROR(tree, TAG, "NULL tree") {
@@ -270,11 +537,17 @@ void *rb_tree_insert(rb_tree_t *tree, const void *ptr) {
         node_t *node;
         RB_TREE_NODE_NEW(tree, node, ptr);
 
-        node->color = BLACK;
+        SET_COLOR(node, BLACK);
 
         TO_ROOT(tree, node);
+        tree->first = node;
+        tree->last = node;
         tree->size++;
 
+        if (tree->countOffset) {
+            COUNT(tree, node) = 1;
+        }
+
         return &node->data;
     } else {
         node_t *tmp = tree->root;
@@ -288,13 +561,11 @@ void *rb_tree_insert(rb_tree_t *tree, const void *ptr) {
                         node_t *node;
                         RB_TREE_NODE_NEW(tree, node, ptr);
 
-                        node->color = RED;
-
-                        TO_SIDE(tmp, left, node);
+                        TO_SIDE(tree, tmp, left, node);
                         tree->size++;
 
-                        RB_TREE_INSERT_BALANCE(tree, tmp)
-                        return &node->data;\
+                        RB_TREE_INSERT_BALANCE(tree, node);
+                        return &node->data;
 
                     }
                     tmp = tmp->left;
@@ -305,13 +576,11 @@ void *rb_tree_insert(rb_tree_t *tree, const void *ptr) {
                         node_t *node;
                         RB_TREE_NODE_NEW(tree, node, ptr);
 
-                        node->color = RED;
-
-                        TO_SIDE(tmp, right, node);
+                        TO_SIDE(tree, tmp, right, node);
                         tree->size++;
 
-                        RB_TREE_INSERT_BALANCE(tree, tmp)
-                        return &node->data;\
+                        RB_TREE_INSERT_BALANCE(tree, node);
+                        return &node->data;
 
                     }
                     tmp = tmp->right;\
@@ -342,11 +611,17 @@ iter_t *rb_tree_insert_iter(rb_tree_t *tree, const void *ptr) {
         node_t *node;
         RB_TREE_NODE_NEW(tree, node, ptr);
 
-        node->color = BLACK;
+        SET_COLOR(node, BLACK);
 
         TO_ROOT(tree, node);
+        tree->first = node;
+        tree->last = node;
         tree->size++;
 
+        if (tree->countOffset) {
+            COUNT(tree, node) = 1;
+        }
+
         iter_t *iter;
         CREATE_ITER(iter, tree->iterPool, node);
         return iter;
@@ -362,12 +637,10 @@ iter_t *rb_tree_insert_iter(rb_tree_t *tree, const void *ptr) {
                         node_t *node;
                         RB_TREE_NODE_NEW(tree, node, ptr);
 
-                        node->color = RED;
-
-                        TO_SIDE(tmp, left, node);
+                        TO_SIDE(tree, tmp, left, node);
                         tree->size++;
 
-                        RB_TREE_INSERT_BALANCE(tree, tmp)
+                        RB_TREE_INSERT_BALANCE(tree, node);
 
                         iter_t *iter;
                         CREATE_ITER(iter, tree->iterPool, node);
@@ -382,12 +655,10 @@ iter_t *rb_tree_insert_iter(rb_tree_t *tree, const void *ptr) {
                         node_t *node;
                         RB_TREE_NODE_NEW(tree, node, ptr);
 
-                        node->color = RED;
-
-                        TO_SIDE(tmp, right, node);
+                        TO_SIDE(tree, tmp, right, node);
                         tree->size++;
 
-                        RB_TREE_INSERT_BALANCE(tree, tmp)
+                        RB_TREE_INSERT_BALANCE(tree, node);
 
                         iter_t *iter;
                         CREATE_ITER(iter, tree->iterPool, node);
@@ -409,6 +680,239 @@ iter_t *rb_tree_insert_iter(rb_tree_t *tree, const void *ptr) {
     }
 }
 
+static node_t *_rb_tree_insert_from(rb_tree_t *tree, node_t *tmp, const void *ptr) {
+    while (1) {
+        int32_t cmpr = tree->compare(ptr, &tmp->data);
+        if (cmpr < 0) {
+            if (!tmp->left) {
+                node_t *node;
+                RB_TREE_NODE_NEW(tree, node, ptr);
+
+                TO_SIDE(tree, tmp, left, node);
+                tree->size++;
+
+                RB_TREE_INSERT_BALANCE(tree, node);
+                return node;
+            }
+            tmp = tmp->left;
+        } else if (cmpr > 0) {
+            if (!tmp->right) {
+                node_t *node;
+                RB_TREE_NODE_NEW(tree, node, ptr);
+
+                TO_SIDE(tree, tmp, right, node);
+                tree->size++;
+
+                RB_TREE_INSERT_BALANCE(tree, node);
+                return node;
+            }
+            tmp = tmp->right;
+        } else {
+            return NULL;
+        }
+    }
+}
+
+/*Climbs from finger to the lowest ancestor whose subtree bounds cover ptr,*/
+/*so lookups near finger cost O(log d) for distance d instead of tree height*/
+static node_t *_rb_tree_finger(rb_tree_t *tree, node_t *node, int32_t cmpr, const void *ptr) {
+    node_t *father;
+    while ((father = PARENT(node))) {
+        if (cmpr > 0 ? father->left == node : father->right == node) {
+            const int32_t sign = SIGN(tree->compare(ptr, &father->data));
+            if (!sign) {
+                return father;
+            } else if (sign != cmpr) {
+                break;
+            }
+        }
+        node = father;
+    }
+
+    return node;
+}
+
+void *rb_tree_insert_hint(rb_tree_t *tree, rb_tree_iter_s *hint, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(hint, TAG, "NULL hint") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    if (!tree->root) {
+        void *result = rb_tree_insert(tree, ptr);
+        hint->node = tree->root;
+        return result;
+    }
+
+    node_t *node = hint->node;
+    const int32_t cmpr = node ? SIGN(tree->compare(ptr, &node->data)) : 0;
+
+    node_t *start;
+    if (!node) {
+        start = tree->root;
+    } else if (!cmpr) {
+        return NULL;
+    } else if (cmpr > 0 && node == tree->last) {
+        /*Appending at the end, no search at all*/
+        start = node;
+    } else if (cmpr < 0 && node == tree->first) {
+        start = node;
+    } else {
+        start = _rb_tree_finger(tree, node, cmpr, ptr);
+    }
+
+    node = _rb_tree_insert_from(tree, start, ptr);
+    if (!node) {
+        return NULL;
+    }
+
+    hint->node = node;
+    return &node->data;
+}
+
+void *rb_tree_find_near(rb_tree_t *tree, rb_tree_iter_s *iter, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return NULL;
+    }
+
+    node_t *tmp = iter->node;
+    if (!tmp) {
+        tmp = _rb_tree_find_node(tree, ptr);
+    } else {
+        const int32_t cmpr = SIGN(tree->compare(ptr, &tmp->data));
+        if (cmpr) {
+            tmp = _rb_tree_finger(tree, tmp, cmpr, ptr);
+
+            while (tmp) {
+                int32_t sign = tree->compare(ptr, &tmp->data);
+                if (sign < 0) {
+                    tmp = tmp->left;
+                } else if (sign > 0) {
+                    tmp = tmp->right;
+                } else {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (!tmp) {
+        return NULL;
+    }
+
+    iter->node = tmp;
+    return &tmp->data;
+}
+
+static uint32_t _rb_tree_free_nodes(rb_tree_t *tree, node_t *node) {
+    uint32_t count = 0;
+    while (node) {
+        count += _rb_tree_free_nodes(tree, node->left) + 1;
+        node_t *right = node->right;
+        FREE_NODE(tree, node);
+        node = right;
+    }
+    return count;
+}
+
+/*Middle element is the root, so both sides differ by one node at most*/
+/*and only the last, incomplete level is colored red*/
+static bool _rb_tree_build(rb_tree_t *tree, const void *array, uint32_t begin, uint32_t end,
+                           uint32_t depth, uint32_t redDepth, node_t **result) {
+    if (begin == end) {
+        *result = NULL;
+        return true;
+    }
+
+    const uint32_t middle = begin + (end - begin) / 2;
+
+    node_t *left;
+    if (!_rb_tree_build(tree, array, begin, middle, depth + 1, redDepth, &left)) {
+        return false;
+    }
+
+    /*Nodes are taken in order, so neighbours end up close in memory*/
+    node_t *node = list_pool_get(tree->nodePool);
+    ASSERT_ERROR(node, TAG, "Can't allocate memory for tree node") {
+        _rb_tree_free_nodes(tree, left);
+        return false;
+    }
+
+    node->parentColor = depth == redDepth ? RED : BLACK;
+    mem_copy(&node->data, array + middle * tree->typeSize, tree->typeSize);
+    TO_SIDE(tree, node, left, left);
+
+    node_t *right;
+    if (!_rb_tree_build(tree, array, middle + 1, end, depth + 1, redDepth, &right)) {
+        _rb_tree_free_nodes(tree, node);
+        return false;
+    }
+
+    TO_SIDE(tree, node, right, right);
+
+    if (tree->countOffset) {
+        COUNT(tree, node) = end - begin;
+    }
+
+    *result = node;
+    return true;
+}
+
+bool rb_tree_build_sorted(rb_tree_t *tree, const void *array, uint32_t count) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    ASSERT_ERROR(array || !count, TAG, "NULL array") {
+        return false;
+    }
+
+    ASSERT_ERROR(!tree->size, TAG, "Tree must be empty: size = %d", tree->size) {
+        return false;
+    }
+
+#ifndef NDEBUG
+    for (uint32_t i = 1; i < count; i++) {
+        ASSERT_ERROR(tree->compare(array + (i - 1) * tree->typeSize, array + i * tree->typeSize) < 0, TAG,
+                     "Array must be sorted without duplicates: index = %d", i) {
+            return false;
+        }
+    }
+#endif
+
+    /*Levels above redDepth are complete*/
+    uint32_t redDepth = 0;
+    while (redDepth < 32 && ((uint64_t)2 << redDepth) - 1 <= count) {
+        redDepth++;
+    }
+
+    node_t *root;
+    if (!_rb_tree_build(tree, array, 0, count, 0, redDepth, &root)) {
+        return false;
+    }
+
+    TO_ROOT(tree, root);
+    _rb_tree_bounds(tree);
+    tree->size = count;
+
+    return true;
+}
+
 void *rb_tree_find(rb_tree_t *tree, const void *ptr) {
     ASSERT_ERROR(tree, TAG, "NULL tree") {
         return NULL;
@@ -452,6 +956,67 @@ void *rb_tree_find(rb_tree_t *tree, const void *ptr) {
     return NULL;
 }
 
+/*Lookups in flight at once, enough to keep the memory system busy without spilling the cursors*/
+#define BATCH_GROUP 16
+
+/*Each round moves every unfinished lookup of the group one level down and prefetches*/
+/*the node it lands on, so the misses of the whole group overlap instead of queueing*/
+static uint32_t _rb_tree_find_group(rb_tree_t *tree, const void *keys, uint32_t count, void **out) {
+    node_t *nodes[BATCH_GROUP];
+    uint32_t active = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        nodes[i] = tree->root;
+        out[i] = NULL;
+        active += nodes[i] != NULL;
+    }
+
+    uint32_t found = 0;
+    while (active) {
+        for (uint32_t i = 0; i < count; i++) {
+            node_t *node = nodes[i];
+            if (!node) {
+                continue;
+            }
+
+            const int32_t cmpr = tree->compare(keys + (uint64_t)i * tree->typeSize, &node->data);
+            if (cmpr) {
+                node = cmpr < 0 ? node->left : node->right;
+                PREFETCH(node);
+            } else {
+                out[i] = &node->data;
+                found++;
+                node = NULL;
+            }
+
+            nodes[i] = node;
+            active -= !node;
+        }
+    }
+
+    return found;
+}
+
+uint32_t rb_tree_find_batch(rb_tree_t *tree, const void *keys, uint32_t count, void **out) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return 0;
+    }
+
+    ASSERT_ERROR(keys || !count, TAG, "NULL keys") {
+        return 0;
+    }
+
+    ASSERT_ERROR(out || !count, TAG, "NULL out") {
+        return 0;
+    }
+
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < count; i += BATCH_GROUP) {
+        found += _rb_tree_find_group(tree, keys + (uint64_t)i * tree->typeSize, MIN(count - i, BATCH_GROUP), out + i);
+    }
+
+    return found;
+}
+
 void *rb_tree_min(rb_tree_t *tree, const void *ptr) {
     ASSERT_ERROR(tree, TAG, "NULL tree") {
         return NULL;
@@ -549,25 +1114,311 @@ void *rb_tree_max(rb_tree_t *tree, const void *ptr) {
         }
     }
 
-    return NULL;
-}
+    return NULL;
+}
+
+static node_t *_rb_tree_select_node(rb_tree_t *tree, uint32_t index) {
+    node_t *tmp = tree->root;
+    while (tmp) {
+        const uint32_t left = SUBTREE_COUNT(tree, tmp->left);
+        if (index < left) {
+            tmp = tmp->left;
+        } else if (index > left) {
+            index -= left + 1;
+            tmp = tmp->right;
+        } else {
+            break;
+        }
+    }
+    return tmp;
+}
+
+void *rb_tree_select(rb_tree_t *tree, uint32_t index) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    RANKED_OR_RETURN(tree, NULL);
+
+    if (index >= tree->size) {
+        return NULL;
+    }
+
+    return &_rb_tree_select_node(tree, index)->data;
+}
+
+static uint32_t _rb_tree_rank(rb_tree_t *tree, const void *ptr, bool *found) {
+    uint32_t rank = 0;
+
+    node_t *tmp = tree->root;
+    while (tmp) {
+        int32_t cmpr = tree->compare(ptr, &tmp->data);
+        if (cmpr < 0) {
+            tmp = tmp->left;
+        } else if (cmpr > 0) {
+            rank += SUBTREE_COUNT(tree, tmp->left) + 1;
+            tmp = tmp->right;
+        } else {
+            *found = true;
+            return rank + SUBTREE_COUNT(tree, tmp->left);
+        }
+    }
+
+    *found = false;
+    return rank;
+}
+
+uint32_t rb_tree_rank(rb_tree_t *tree, const void *ptr) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return 0;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return 0;
+    }
+
+    RANKED_OR_RETURN(tree, 0);
+
+    bool found;
+    return _rb_tree_rank(tree, ptr, &found);
+}
+
+uint32_t rb_tree_count_range(rb_tree_t *tree, const void *min, const void *max) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return 0;
+    }
+
+    ASSERT_ERROR(min && max, TAG, "NULL bound") {
+        return 0;
+    }
+
+    RANKED_OR_RETURN(tree, 0);
+
+    if (tree->compare(min, max) >= 0) {
+        return 0;
+    }
+
+    /*Rank counts keys less than bound, so the difference is the half-open [min, max)*/
+    bool found;
+    const uint32_t first = _rb_tree_rank(tree, min, &found);
+    const uint32_t last = _rb_tree_rank(tree, max, &found);
+
+    return last - first;
+}
+
+void rb_tree_foreach(rb_tree_t *tree, action_f func, void *data) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return;
+    }
+
+    node_t *tmp = tree->root;
+    if (tmp) {
+        while (tmp->left) {
+            tmp = tmp->left;
+        }
+
+        while (tmp) {
+            func(&tmp->data, data);
+            NEXT(tmp);
+        }
+    }
+}
+
+void rb_tree_foreach_range(rb_tree_t *tree, const void *min, const void *max, action_f func, void *data) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return;
+    }
+
+    ASSERT_ERROR(min && max, TAG, "NULL bound") {
+        return;
+    }
+
+    ASSERT_ERROR(func, TAG, "NULL action") {
+        return;
+    }
+
+    node_t *tmp = _rb_tree_min_node(tree, min);
+    while (tmp && tree->compare(&tmp->data, max) < 0) {
+        func(&tmp->data, data);
+        NEXT(tmp);
+    }
+}
+
+/*Chunks per thread, spare chunks even out unequal subtrees between threads*/
+#define PARALLEL_CHUNKS 4
+
+/*Chunk i is the in-order run from bounds[i] up to bounds[i + 1], which is excluded*/
+typedef struct parallel_t {
+    rb_tree_t *tree;
+    node_t **bounds;
+    uint32_t chunks;
+    atomic_uint next;
+    action_f func;
+    reduce_f reduce;
+    void *accs;
+    uint32_t accSize;
+    void *data;
+} parallel_t;
+
+static void *_rb_tree_parallel_worker(void *arg) {
+    parallel_t *parallel = arg;
+
+    uint32_t index;
+    while ((index = atomic_fetch_add_explicit(&parallel->next, 1, memory_order_relaxed)) < parallel->chunks) {
+        node_t *end = parallel->bounds[index + 1];
+        void *acc = parallel->reduce ? parallel->accs + (uint64_t)index * parallel->accSize : NULL;
+
+        node_t *tmp = parallel->bounds[index];
+        while (tmp != end) {
+            if (parallel->reduce) {
+                parallel->reduce(acc, &tmp->data, parallel->data);
+            } else {
+                parallel->func(&tmp->data, parallel->data);
+            }
+            NEXT(tmp);
+        }
+    }
+
+    return NULL;
+}
+
+static void _rb_tree_collect_bounds(node_t *node, uint32_t depth, node_t **bounds, uint32_t *count) {
+    if (node && depth) {
+        _rb_tree_collect_bounds(node->left, depth - 1, bounds, count);
+        bounds[(*count)++] = node;
+        _rb_tree_collect_bounds(node->right, depth - 1, bounds, count);
+    }
+}
+
+/*Ranked trees are cut into runs of equal length, others at the nodes of the top levels*/
+static uint32_t _rb_tree_parallel_bounds(rb_tree_t *tree, node_t **bounds, uint32_t chunks) {
+    if (tree->countOffset) {
+        for (uint32_t i = 0; i < chunks; i++) {
+            bounds[i] = _rb_tree_select_node(tree, (uint64_t)tree->size * i / chunks);
+        }
+    } else {
+        uint32_t depth = 0;
+        while ((2u << depth) <= chunks) {
+            depth++;
+        }
+
+        bounds[0] = tree->first;
+        chunks = 1;
+        _rb_tree_collect_bounds(tree->root, depth, bounds, &chunks);
+    }
+
+    bounds[chunks] = NULL;
+    return chunks;
+}
+
+static bool _rb_tree_parallel(rb_tree_t *tree, uint32_t threads, parallel_t *parallel) {
+    threads = MAX(threads, 1);
+    const uint32_t chunks = MIN(threads * PARALLEL_CHUNKS, MAX(tree->size, 1));
+
+    parallel->tree = tree;
+    parallel->bounds = alloc_malloc(tree->alloc, sizeof(node_t *) * (chunks + 1));
+
+    ASSERT_ERROR(parallel->bounds, TAG, "Can't allocate memory for chunks") {
+        return false;
+    }
+
+    parallel->chunks = _rb_tree_parallel_bounds(tree, parallel->bounds, chunks);
+    atomic_init(&parallel->next, 0);
+
+    if (parallel->reduce) {
+        parallel->accs = alloc_malloc(tree->alloc, (uint64_t)parallel->chunks * parallel->accSize);
+
+        ASSERT_ERROR(parallel->accs, TAG, "Can't allocate memory for accumulators") {
+            alloc_free(tree->alloc, parallel->bounds);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*Caller thread works too, threads that fail to start just leave more chunks to the others*/
+static void _rb_tree_parallel_run(parallel_t *parallel, uint32_t threads) {
+    pthread_t *workers = threads > 1 ? alloc_malloc(parallel->tree->alloc, sizeof(pthread_t) * (threads - 1)) : NULL;
+
+    uint32_t started = 0;
+    while (workers && started < threads - 1 &&
+           !pthread_create(&workers[started], NULL, _rb_tree_parallel_worker, parallel)) {
+        started++;
+    }
+
+    _rb_tree_parallel_worker(parallel);
+
+    for (uint32_t i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    if (workers) {
+        alloc_free(parallel->tree->alloc, workers);
+    }
+    alloc_free(parallel->tree->alloc, parallel->bounds);
+}
+
+void rb_tree_parallel_foreach(rb_tree_t *tree, uint32_t threads, action_f func, void *data) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return;
+    }
+
+    ASSERT_ERROR(func, TAG, "NULL action") {
+        return;
+    }
+
+    parallel_t parallel;
+    parallel.func = func;
+    parallel.reduce = NULL;
+    parallel.accs = NULL;
+    parallel.accSize = 0;
+    parallel.data = data;
+
+    if (!_rb_tree_parallel(tree, threads, &parallel)) {
+        return;
+    }
+
+    _rb_tree_parallel_run(&parallel, threads);
+}
+
+/*Chunks fold into copies of identity and are combined into acc in key order, so acc counts once*/
+bool rb_tree_parallel_reduce(rb_tree_t *tree, uint32_t threads, reduce_f reduce, combine_f combine,
+                             const void *identity, void *acc, uint32_t accSize, void *data) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    ASSERT_ERROR(reduce && combine, TAG, "NULL reduce") {
+        return false;
+    }
+
+    ASSERT_ERROR(identity && acc && accSize, TAG, "NULL accumulator") {
+        return false;
+    }
 
-void rb_tree_foreach(rb_tree_t *tree, action_f func, void *data) {
-    ASSERT_ERROR(tree, TAG, "NULL tree") {
-        return;
+    parallel_t parallel;
+    parallel.func = NULL;
+    parallel.reduce = reduce;
+    parallel.accSize = accSize;
+    parallel.data = data;
+
+    if (!_rb_tree_parallel(tree, threads, &parallel)) {
+        return false;
     }
 
-    node_t *tmp = tree->root;
-    if (tmp) {
-        while (tmp->left) {
-            tmp = tmp->left;
-        }
+    for (uint32_t i = 0; i < parallel.chunks; i++) {
+        mem_copy(parallel.accs + (uint64_t)i * accSize, identity, accSize);
+    }
 
-        while (tmp) {
-            func(&tmp->data, data);
-            NEXT(tmp);
-        }
+    _rb_tree_parallel_run(&parallel, threads);
+
+    for (uint32_t i = 0; i < parallel.chunks; i++) {
+        combine(acc, parallel.accs + (uint64_t)i * accSize, data);
     }
+
+    alloc_free(tree->alloc, parallel.accs);
+    return true;
 }
 
 iter_t *rb_tree_iter(rb_tree_t *tree) {
@@ -737,255 +1588,26 @@ iter_t *rb_tree_max_iter(rb_tree_t *tree, const void *ptr) {
 }
 
 
-#define RB_TREE_REMOVE_BALANCE(tree, target)\
-do {\
-    node_t *toDelete = target;\
-    node_t *father = target->parent;\
-\
-    /* If node is RED, it's definitely has no children, no need to balance */\
-    if (target->color == RED) {\
-        if (father) {\
-            if (father->left == target) {\
-                father->left = NULL;\
-            } else {\
-                father->right = NULL;\
-            }\
-        } else {\
-            tree->root = NULL;\
-        }\
-    } else {\
-        node_t *child = (node_t *) ((WST) target->left | (WST) target->right);\
-        if (child) {\
-            /* Has child, just passing child to replace node, no need to balance */\
-            child->color = BLACK;\
-\
-            if (father) {\
-                if (father->left == target) {\
-                    TO_SIDE(father, left, child);\
-                } else {\
-                    TO_SIDE(father, right, child);\
-                }\
-            } else {\
-                TO_ROOT(tree, child);\
-            }\
-        } else {\
-            /* Node hasn't children, balancing */\
-\
-            if (father) {\
-                if (father->left == target) {\
-                    target = NULL;\
-                    father->left = NULL;\
-                    goto definitely_has_parent;\
-                } else {\
-                    target = NULL;\
-                    father->right = NULL;\
-                    goto definitely_has_parent;\
-                }\
-            } else {\
-                tree->root = NULL;\
-                goto done;\
-            }\
-            \
-\
-            check_iteration:\
-\
-            if (!target->parent) {\
-                /* First case: Problem target is Root */\
-                /* Just recolor */\
-                /* Termination */\
-\
-                target->color = BLACK;\
-\
-                goto done;\
-            } else {\
-                father = target->parent;\
-\
-                definitely_has_parent:;\
-\
-                node_t *brother = (node_t *) FTERNP(father->left == target,\
-                                                    father->right,\
-                                                    father->left);\
-\
-                node_t *farNephew = (node_t *) FTERNP(father->left == target,\
-                                                      brother->right,\
-                                                      brother->left);\
-\
-                node_t *nearNephew = (node_t *) FTERNP(father->left == target,\
-                                                       brother->left,\
-                                                       brother->right);\
-\
-                if (father->color == BLACK) {\
-                    if (brother->color == RED) {\
-                        /* Second case: BLACK parent, RED brother */\
-                        /* Turn with recolor */\
-                        /* Go to "definitely_has_parent" */\
-                        node_t *grand = father->parent;\
-\
-                        if (father->left == target) {\
-                            TO_SIDE(father, right, nearNephew);\
-                            TO_SIDE(brother, left, father);\
-                        } else {\
-                            TO_SIDE(father, left, nearNephew);\
-                            TO_SIDE(brother, right, father);\
-                        }\
-\
-                        father->color = RED;\
-                        brother->color = BLACK;\
-\
-                        if (grand) {\
-                            if (grand->left == father) {\
-                                TO_SIDE(grand, left, brother);\
-                            } else {\
-                                TO_SIDE(grand, right, brother);\
-                            }\
-                        } else {\
-                            TO_ROOT(tree, brother);\
-                        }\
-\
-                        goto definitely_has_parent;\
-                    } else {\
-                        if (farNephew && farNephew->color == RED) {\
-                            goto case_six;\
-                        } else {\
-                            if (!nearNephew || nearNephew->color == BLACK) {\
-                                /* Third case: BLACK parent, BLACK nephews */\
-                                /* Just recolor */\
-                                /* To next loop iteration */\
-\
-                                brother->color = RED;\
-                                target = father;\
-\
-                                goto check_iteration;\
-                            } else {\
-                                /* Fifth case: BLACK parent, RED far nephew */\
-                                /* Turn with recolor */\
-                                /* Go to case 6 */\
-\
-                                brother->color = RED;\
-                                nearNephew->color = BLACK;\
-\
-                                if (father->left == target) {\
-                                    TO_SIDE(father, right, nearNephew);\
-                                    TO_SIDE(brother, left, nearNephew->right);\
-                                    TO_SIDE(nearNephew, right, brother);\
-\
-                                    farNephew = brother;\
-                                    brother = nearNephew;\
-                                    nearNephew = nearNephew->left;\
-\
-                                } else {\
-                                    TO_SIDE(father, left, nearNephew);\
-                                    TO_SIDE(brother, right, nearNephew->left);\
-                                    TO_SIDE(nearNephew, left, brother);\
-\
-                                    farNephew = brother;\
-                                    brother = nearNephew;\
-                                    nearNephew = nearNephew->right;\
-                                }\
-                                goto case_six;\
-                            }\
-                        }\
-                    }\
-                } else {\
-                    if (!farNephew || farNephew->color == BLACK) {\
-                        /* Forth case: RED parent, far nephew is BLACK */\
-                        /* Just recolor */\
-                        /* Termination */\
-\
-                        father->color = BLACK;\
-                        brother->color = RED;\
-\
-                        goto done;\
-                    } else {\
-                        case_six:;\
-                        /* Six case: No matter parent end near nephew, far nephew is RED */\
-                        /* Turn with recolor */\
-                        /* Termination */\
-                        node_t *grand = father->parent;\
-\
-                        if (father->left == target) {\
-                            TO_SIDE(father, right, nearNephew);\
-                            TO_SIDE(brother, left, father);\
-                        } else {\
-                            TO_SIDE(father, left, nearNephew);\
-                            TO_SIDE(brother, right, father);\
-                        }\
-\
-                        farNephew->color = BLACK;\
-                        brother->color = father->color;\
-                        father->color = BLACK;\
-\
-                        if (grand) {\
-                            if (grand->left == father) {\
-                                TO_SIDE(grand, left, brother);\
-                            } else {\
-                                TO_SIDE(grand, right, brother);\
-                            }\
-                        } else {\
-                            TO_ROOT(tree, brother);\
-                        }\
-\
-                        goto done;\
-                    }\
-                }\
-            }\
-        }\
-    }\
-    done:\
-    list_pool_free(tree->nodePool, toDelete);\
-} while (0)
+/*Unlinks target from the tree; nodes are relinked, never copied, so data pointers stay valid*/
+static void _rb_tree_unlink(rb_tree_t *tree, node_t *target) {
+    if (target == tree->first) {
+        NEXT(tree->first);
+    }
+    if (target == tree->last) {
+        PREV(tree->last);
+    }
+
+    _rb_balance_unlink(tree, target);
+}
 
 #define RB_TREE_REMOVE(tree, target) \
 do {\
-    /* We need our node has no or one child */\
-    if (target->left && target->right) {\
-        /* Our node has two children, finding donor */\
-        node_t *father = target->parent;\
-        node_t *donor = target;\
-        \
-        donor = donor->right;\
-        while (donor->left) {\
-            donor = donor->left;\
-        }\
-        node_t *fdonor = donor->parent;\
-        \
-        /* Changing target node with donor */\
-        node_t bufferNode = *donor;\
-        *donor = *target;\
-        *target = bufferNode;\
-        \
-        donor->left->parent = donor;\
-        \
-        if (father) {\
-            if (father->left == target) {\
-                TO_SIDE(father, left, donor);\
-            } else {\
-                TO_SIDE(father, right, donor);\
-            }\
-        } else {\
-            TO_ROOT(tree, donor);\
-        }\
-        \
-        if (fdonor == target) {\
-            if (donor->left == donor) {\
-                TO_SIDE(donor, left, target);\
-            } else {\
-                TO_SIDE(donor, right, target);\
-            }\
-        } else {\
-            if (fdonor->left == donor) {\
-                TO_SIDE(fdonor, left, target);\
-            } else {\
-                TO_SIDE(fdonor, right, target);\
-            }\
-        }\
-    }\
-    \
     if (dst) {\
         mem_copy(dst, &target->data, tree->typeSize);\
     }\
     \
-    RB_TREE_REMOVE_BALANCE(tree, target);\
+    _rb_tree_unlink(tree, target);\
+    FREE_NODE(tree, target);\
 } while (0)
 
 
@@ -1149,42 +1771,504 @@ bool rb_tree_remove_iter(rb_tree_t *tree, iter_t *iter, void *dst) {
         return false;
     }
 
-    ASSERT_ERROR(list_pool_has(tree->nodePool, ITER(&iter->data)->node), TAG, "Node on iterator stack not belong to tree") {
+    ASSERT_ERROR(list_pool_has(tree->nodePool, ITER(iter)->node), TAG, "Node on iterator stack not belong to tree") {
         return false;
     }
 
-    if (!ITER(&iter->data)->node) {
+    if (!ITER(iter)->node) {
         return false;
     }
 
-    RB_TREE_REMOVE(tree, ITER(&iter->data)->node);
+    RB_TREE_REMOVE(tree, ITER(iter)->node);
 
     iter_term(iter);
     tree->size--;
     return true;
 }
 
-inline size_t rb_tree_size(rb_tree_t *tree) {
+bool rb_tree_remove_iter_tmp(rb_tree_t *tree, rb_tree_iter_s *iter, void *dst) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return false;
+    }
+
+    if (!iter->node) {
+        return false;
+    }
+
+    node_t *node = iter->node;
+    iter->node = NULL;
+
+    RB_TREE_REMOVE(tree, node);
+
+    tree->size--;
+    return true;
+}
+
+static uint32_t _rb_tree_black_height(node_t *node) {
+    uint32_t height = 0;
+    for (; node; node = node->left) {
+        height += COLOR(node) == BLACK;
+    }
+    return height;
+}
+
+#define DETACH(node)\
+do {\
+    if (node) {\
+        (node)->parentColor = BLACK;\
+    }\
+} while (0)
+
+/*Joins detached subtrees around pivot, all left keys are less than pivot and all right ones are greater*/
+/*Pivot hangs on the spine of the higher tree at equal black height, then red violation is fixed upward*/
+static node_t *_rb_tree_join(rb_tree_t *tree, node_t *left, node_t *pivot, node_t *right) {
+    uint32_t leftHeight = _rb_tree_black_height(left);
+    uint32_t rightHeight = _rb_tree_black_height(right);
+
+    rb_tree_t view = *tree;
+
+    if (leftHeight == rightHeight) {
+        pivot->parentColor = BLACK;
+        TO_SIDE(tree, pivot, left, left);
+        TO_SIDE(tree, pivot, right, right);
+        if (tree->countOffset) {
+            UPDATE_COUNT(tree, pivot);
+        }
+        return pivot;
+    } else if (leftHeight > rightHeight) {
+        node_t *father = NULL;
+        node_t *tmp = left;
+        while (leftHeight > rightHeight || IS_RED(tmp)) {
+            leftHeight -= !IS_RED(tmp);
+            father = tmp;
+            tmp = tmp->right;
+        }
+
+        pivot->parentColor = RED;
+        TO_SIDE(tree, pivot, left, tmp);
+        TO_SIDE(tree, pivot, right, right);
+        TO_SIDE(tree, father, right, pivot);
+
+        view.root = left;
+    } else {
+        node_t *father = NULL;
+        node_t *tmp = right;
+        while (rightHeight > leftHeight || IS_RED(tmp)) {
+            rightHeight -= !IS_RED(tmp);
+            father = tmp;
+            tmp = tmp->left;
+        }
+
+        pivot->parentColor = RED;
+        TO_SIDE(tree, pivot, right, tmp);
+        TO_SIDE(tree, pivot, left, left);
+        TO_SIDE(tree, father, left, pivot);
+
+        view.root = right;
+    }
+
+    if (tree->countOffset) {
+        for (node_t *node = pivot; node; node = PARENT(node)) {
+            UPDATE_COUNT(tree, node);
+        }
+    }
+
+    _rb_balance_insert(&view, pivot);
+    return view.root;
+}
+
+static node_t *_rb_tree_join2(rb_tree_t *tree, node_t *left, node_t *right) {
+    if (!right) {
+        return left;
+    }
+
+    node_t *pivot = right;
+    while (pivot->left) {
+        pivot = pivot->left;
+    }
+
+    rb_tree_t view = *tree;
+    view.root = right;
+    _rb_tree_unlink(&view, pivot);
+    DETACH(view.root);
+
+    return _rb_tree_join(tree, left, pivot, view.root);
+}
+
+/*Splits detached subtree in keys less than ptr and the rest*/
+/*Equal node goes to right, or is cut out into equal when it is given*/
+static void _rb_tree_split(rb_tree_t *tree, node_t *node, const void *ptr, node_t **left, node_t **right,
+                           node_t **equal) {
+    if (!node) {
+        *left = NULL;
+        *right = NULL;
+        return;
+    }
+
+    node_t *leftChild = node->left;
+    node_t *rightChild = node->right;
+    DETACH(leftChild);
+    DETACH(rightChild);
+
+    const int32_t cmpr = tree->compare(ptr, &node->data);
+
+    if (!cmpr && equal) {
+        *left = leftChild;
+        *right = rightChild;
+        *equal = node;
+        return;
+    } else if (cmpr <= 0) {
+        node_t *middle;
+        _rb_tree_split(tree, leftChild, ptr, left, &middle, equal);
+        *right = _rb_tree_join(tree, middle, node, rightChild);
+    } else {
+        node_t *middle;
+        _rb_tree_split(tree, rightChild, ptr, &middle, right, equal);
+        *left = _rb_tree_join(tree, leftChild, node, middle);
+    }
+
+    DETACH(*left);
+    DETACH(*right);
+}
+
+uint32_t rb_tree_remove_range(rb_tree_t *tree, const void *min, const void *max) {
     ASSERT_ERROR(tree, TAG, "NULL tree") {
         return 0;
     }
 
-    return tree->size;
+    ASSERT_ERROR(min && max, TAG, "NULL bound") {
+        return 0;
+    }
+
+    if (tree->compare(min, max) >= 0) {
+        return 0;
+    }
+
+    node_t *left;
+    node_t *middle;
+    node_t *right;
+
+    _rb_tree_split(tree, tree->root, min, &left, &right, NULL);
+    _rb_tree_split(tree, right, max, &middle, &right, NULL);
+
+    const uint32_t count = _rb_tree_free_nodes(tree, middle);
+
+    tree->root = _rb_tree_join2(tree, left, right);
+    _rb_tree_bounds(tree);
+    tree->size -= count;
+
+    return count;
 }
 
-void rb_tree_clear(rb_tree_t *tree) {
+/*Ranked trees know subtree sizes. Plain ones count the smaller half in lockstep with the larger one,*/
+/*which costs O(min(k, n - k)) on top of the O(log n) split*/
+static uint32_t _rb_tree_resize(rb_tree_t *tree, rb_tree_t *other, uint32_t total) {
+    if (tree->countOffset) {
+        return SUBTREE_COUNT(tree, tree->root);
+    }
+
+    uint32_t count = 0;
+    node_t *node = tree->first;
+    node_t *otherNode = other->first;
+    while (node && otherNode) {
+        NEXT(node);
+        NEXT(otherNode);
+        count++;
+    }
+    return node ? total - count : count;
+}
+
+#define RB_TREE_SIBLINGS(tree, other) ((tree)->nodePool == (other)->nodePool && (tree) != (other))
+
+/*Relinking nodes into a tree with another pool would corrupt both, so this stays in release builds*/
+#define SIBLINGS_OR_RETURN(tree, other, result)\
+do {\
+    if (!RB_TREE_SIBLINGS(tree, other)) {\
+        log_error(TAG, "Trees don't share node pool");\
+        return result;\
+    }\
+} while (0)
+
+bool rb_tree_split(rb_tree_t *tree, const void *ptr, rb_tree_t *right) {
+    ASSERT_ERROR(tree && right, TAG, "NULL tree") {
+        return false;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL key") {
+        return false;
+    }
+
+    SIBLINGS_OR_RETURN(tree, right, false);
+
+    if (right->root) {
+        log_error(TAG, "Right tree isn't empty");
+        return false;
+    }
+
+    _rb_tree_split(tree, tree->root, ptr, &tree->root, &right->root, NULL);
+    _rb_tree_bounds(tree);
+    _rb_tree_bounds(right);
+
+    const uint32_t total = tree->size;
+    right->size = _rb_tree_resize(right, tree, total);
+    tree->size = total - right->size;
+
+    return true;
+}
+
+bool rb_tree_join(rb_tree_t *left, rb_tree_t *right) {
+    ASSERT_ERROR(left && right, TAG, "NULL tree") {
+        return false;
+    }
+
+    SIBLINGS_OR_RETURN(left, right, false);
+
+    if (!right->root) {
+        return true;
+    }
+
+    if (left->root && left->compare(&left->last->data, &right->first->data) >= 0) {
+        log_error(TAG, "Trees keys overlap");
+        return false;
+    }
+
+    DETACH(left->root);
+    left->root = _rb_tree_join2(left, left->root, right->root);
+    left->first = left->first ? left->first : right->first;
+    left->last = right->last;
+    left->size += right->size;
+
+    right->root = NULL;
+    right->first = NULL;
+    right->last = NULL;
+    right->size = 0;
+
+    return true;
+}
+
+/*Splits tree around root of other and merges halves recursively, equal node of other is freed*/
+static node_t *_rb_tree_union(rb_tree_t *tree, node_t *node, node_t *other, uint32_t *count) {
+    if (!node) {
+        return other;
+    } else if (!other) {
+        return node;
+    }
+
+    node_t *otherLeft = other->left;
+    node_t *otherRight = other->right;
+    DETACH(otherLeft);
+    DETACH(otherRight);
+
+    node_t *left;
+    node_t *right;
+    node_t *pivot = NULL;
+    _rb_tree_split(tree, node, &other->data, &left, &right, &pivot);
+
+    if (pivot) {
+        FREE_NODE(tree, other);
+        (*count)++;
+    } else {
+        pivot = other;
+    }
+
+    left = _rb_tree_union(tree, left, otherLeft, count);
+    right = _rb_tree_union(tree, right, otherRight, count);
+    DETACH(left);
+    DETACH(right);
+
+    return _rb_tree_join(tree, left, pivot, right);
+}
+
+uint32_t rb_tree_merge(rb_tree_t *tree, rb_tree_t *other) {
+    ASSERT_ERROR(tree && other, TAG, "NULL tree") {
+        return 0;
+    }
+
+    SIBLINGS_OR_RETURN(tree, other, 0);
+
+    uint32_t count = 0;
+
+    DETACH(tree->root);
+    DETACH(other->root);
+    tree->root = _rb_tree_union(tree, tree->root, other->root, &count);
+    DETACH(tree->root);
+    _rb_tree_bounds(tree);
+    tree->size += other->size - count;
+
+    other->root = NULL;
+    other->first = NULL;
+    other->last = NULL;
+    other->size = 0;
+
+    return count;
+}
+
+/*Copies subtree in order, so NEXT walks the new nodes by increasing addresses*/
+static node_t *_rb_tree_relocate(rb_tree_t *tree, list_pool_t *pool, node_t *node, bool *ok) {
+    if (!node || !*ok) {
+        return NULL;
+    }
+
+    node_t *child = _rb_tree_relocate(tree, pool, node->left, ok);
+    node_t *copy = *ok ? list_pool_get(pool) : NULL;
+
+    if (!copy) {
+        *ok = false;
+        return NULL;
+    }
+
+    mem_copy(copy, node, tree->nodeSize);
+    TO_SIDE(tree, copy, left, child);
+
+    child = _rb_tree_relocate(tree, pool, node->right, ok);
+    TO_SIDE(tree, copy, right, child);
+
+    return copy;
+}
+
+bool rb_tree_compact(rb_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    /*Siblings and retired nodes still point into the old pool, so this stays in release builds*/
+    if ((tree->poolRefs && *tree->poolRefs > 1) || tree->retire) {
+        log_error(TAG, "Node pool is shared");
+        return false;
+    }
+
+    list_pool_t *pool = list_pool_init_via(tree->alloc, tree->nodeSize, tree->bufferSize);
+
+    ASSERT_ERROR(pool, TAG, "Can't allocate memory for pool") {
+        return false;
+    }
+
+    bool ok = true;
+    node_t *root = _rb_tree_relocate(tree, pool, tree->root, &ok);
+
+    if (!ok) {
+        list_pool_term(pool);
+        return false;
+    }
+
+    list_pool_term(tree->nodePool);
+    tree->nodePool = pool;
+    tree->root = root;
+    if (root) {
+        SET_PARENT(root, NULL);
+    }
+    _rb_tree_bounds(tree);
+
+    return true;
+}
+
+cmp_f rb_tree_compare(rb_tree_t *tree) {
+    return tree->compare;
+}
+
+uint32_t rb_tree_type_size(rb_tree_t *tree) {
+    return tree->typeSize;
+}
+
+void rb_tree_retire_via(rb_tree_t *tree, action_f retire, void *data) {
     ASSERT_ERROR(tree, TAG, "NULL tree") {
         return;
     }
 
-    node_t *tmp = tree->root;
-    while (tmp) {
-        node_t *child = (node_t *)FTERNP(tmp->left != NULL, tmp->left, tmp->right);
-        if (child) {
-            tmp = child;
+    tree->retire = retire;
+    tree->retireData = data;
+}
+
+void rb_tree_free_node(rb_tree_t *tree, void *node) {
+    ASSERT_ERROR(tree && node, TAG, "NULL node") {
+        return;
+    }
+
+    list_pool_free(tree->nodePool, node);
+}
+
+/*Gives up after depth steps, a concurrent writer may leave a cycle for a moment*/
+void *rb_tree_find_bounded(rb_tree_t *tree, const void *ptr, uint32_t depth) {
+    node_t *tmp = LINK_LOAD(tree->root);
+    while (tmp && depth--) {
+        const int32_t cmpr = tree->compare(ptr, &tmp->data);
+        if (cmpr < 0) {
+            tmp = LINK_LOAD(tmp->left);
+        } else if (cmpr > 0) {
+            tmp = LINK_LOAD(tmp->right);
         } else {
-            list_pool_free(tree->nodePool, tmp);
-            tmp = tmp->parent;
+            return &tmp->data;
+        }
+    }
+    return NULL;
+}
+
+uint32_t rb_tree_size(rb_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return 0;
+    }
+
+    return tree->size;
+}
+
+/*Balance, order, bounds, size and ranked subtree counts*/
+bool rb_tree_check(rb_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    if ((tree->root && COLOR(tree->root) != BLACK) || _rb_balance_check(tree->root, NULL) < 0) {
+        return false;
+    }
+
+    node_t *first = tree->root;
+    while (first && first->left) {
+        first = first->left;
+    }
+
+    uint32_t count = 0;
+    node_t *prev = NULL;
+    node_t *tmp = first;
+    while (tmp) {
+        if (prev && tree->compare(&prev->data, &tmp->data) >= 0) {
+            return false;
+        }
+
+        if (tree->countOffset &&
+            COUNT(tree, tmp) != SUBTREE_COUNT(tree, tmp->left) + SUBTREE_COUNT(tree, tmp->right) + 1) {
+            return false;
         }
+
+        count++;
+        prev = tmp;
+        NEXT(tmp);
+    }
+
+    return count == tree->size && tree->first == first && tree->last == prev;
+}
+
+/*Exclusive node pool is dropped wholesale, shared one gets its nodes back one by one*/
+void rb_tree_reset(rb_tree_t *tree, bool keepBlocks) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return;
+    }
+
+    if ((tree->poolRefs && *tree->poolRefs > 1) || tree->retire) {
+        _rb_tree_free_nodes(tree, tree->root);
+    } else {
+        list_pool_reset(tree->nodePool, keepBlocks);
     }
+
+    tree->root = NULL;
+    tree->first = NULL;
+    tree->last = NULL;
+    tree->size = 0;
+}
+
+void rb_tree_clear(rb_tree_t *tree) {
+    rb_tree_reset(tree, true);
 }
\ No newline at end of file
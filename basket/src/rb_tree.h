@@ -0,0 +1,18 @@
+#ifndef MEAL_BASKET_RB_TREE_IMPL_H
+#define MEAL_BASKET_RB_TREE_IMPL_H
+
+#include "meal/rb_tree.h"
+
+#include "meal/def.h"
+
+cmp_f rb_tree_compare(rb_tree_t *tree);
+
+uint32_t rb_tree_type_size(rb_tree_t *tree);
+
+void rb_tree_retire_via(rb_tree_t *tree, action_f retire, void *data);
+
+void rb_tree_free_node(rb_tree_t *tree, void *node);
+
+void *rb_tree_find_bounded(rb_tree_t *tree, const void *ptr, uint32_t depth);
+
+#endif // MEAL_BASKET_RB_TREE_IMPL_H
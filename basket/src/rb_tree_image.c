@@ -0,0 +1,370 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "meal/rb_tree_image.h"
+
+#include "meal/assert.h"
+#include "meal/memory.h"
+#include "rb_tree.h"
+
+#include <stdio.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define MAPPED
+#endif
+
+#define TAG "RB Tree Image"
+
+#define IMAGE_MAGIC 0x5442524Du
+
+#define IMAGE_VERSION 1
+
+/*Reads back as 0x0201 on a machine of the other byte order*/
+#define IMAGE_ENDIAN 0x0102
+
+#define SAVE_BUFFER 4096
+
+/*Elements follow the header sorted and packed, so the image is searched in place*/
+typedef struct image_header_t {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t endian;
+    uint32_t typeSize;
+    uint32_t count;
+} image_header_t;
+
+typedef struct rb_tree_image_t {
+    const alloc_t *alloc;
+    cmp_f compare;
+    void *map;
+    uint64_t mapSize;
+    const void *data;
+    uint32_t typeSize;
+    uint32_t size;
+} rb_tree_image_t;
+
+#define AT(image, index) ((image)->data + (uint64_t)(index) * (image)->typeSize)
+
+typedef struct save_t {
+    writer_f writer;
+    void *data;
+    uint32_t used;
+    bool failed;
+    char buffer[SAVE_BUFFER];
+} save_t;
+
+static void _rb_tree_image_write(save_t *save, const void *ptr, uint32_t count) {
+    if (save->failed) {
+        return;
+    }
+
+    if (save->used + count > SAVE_BUFFER && save->used) {
+        save->failed = save->writer(save->buffer, save->used, save->data) == -1;
+        save->used = 0;
+    }
+
+    if (count > SAVE_BUFFER) {
+        save->failed = save->failed || save->writer(ptr, count, save->data) == -1;
+    } else {
+        mem_copy(save->buffer + save->used, ptr, count);
+        save->used += count;
+    }
+}
+
+typedef struct save_item_t {
+    save_t *save;
+    uint32_t typeSize;
+} save_item_t;
+
+static void _rb_tree_image_save_item(void *ptr, void *data) {
+    save_item_t *item = data;
+    _rb_tree_image_write(item->save, ptr, item->typeSize);
+}
+
+bool rb_tree_save(rb_tree_t *tree, writer_f writer, void *data) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    ASSERT_ERROR(writer, TAG, "NULL writer") {
+        return false;
+    }
+
+    save_t save;
+    save.writer = writer;
+    save.data = data;
+    save.used = 0;
+    save.failed = false;
+
+    image_header_t header;
+    header.magic = IMAGE_MAGIC;
+    header.version = IMAGE_VERSION;
+    header.endian = IMAGE_ENDIAN;
+    header.typeSize = rb_tree_type_size(tree);
+    header.count = rb_tree_size(tree);
+    _rb_tree_image_write(&save, &header, sizeof(image_header_t));
+
+    save_item_t item = {&save, header.typeSize};
+    rb_tree_foreach(tree, _rb_tree_image_save_item, &item);
+
+    if (!save.failed && save.used) {
+        save.failed = writer(save.buffer, save.used, data) == -1;
+    }
+
+    return !save.failed;
+}
+
+static int32_t _rb_tree_image_file_writer(const char *buffer, uint32_t count, void *data) {
+    return fwrite(buffer, 1, count, data) == count ? (int32_t)count : -1;
+}
+
+bool rb_tree_save_file(rb_tree_t *tree, const char *path) {
+    ASSERT_ERROR(path, TAG, "NULL path") {
+        return false;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+
+    const bool result = rb_tree_save(tree, _rb_tree_image_file_writer, file);
+    return !fclose(file) && result;
+}
+
+#ifdef MAPPED
+
+static bool _rb_tree_image_map(rb_tree_image_t *image, const char *path) {
+    const int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) || !info.st_size) {
+        close(fd);
+        return false;
+    }
+
+    image->mapSize = info.st_size;
+    image->map = mmap(NULL, image->mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    return image->map != MAP_FAILED;
+}
+
+static void _rb_tree_image_unmap(rb_tree_image_t *image) {
+    munmap(image->map, image->mapSize);
+}
+
+#else
+
+static bool _rb_tree_image_map(rb_tree_image_t *image, const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+
+    long size = -1;
+    if (!fseek(file, 0, SEEK_END)) {
+        size = ftell(file);
+    }
+
+    if (size <= 0 || size > UINT32_MAX || fseek(file, 0, SEEK_SET)) {
+        fclose(file);
+        return false;
+    }
+
+    image->mapSize = size;
+    image->map = alloc_malloc(image->alloc, image->mapSize);
+    const bool result = image->map && fread(image->map, 1, image->mapSize, file) == image->mapSize;
+    fclose(file);
+
+    if (!result && image->map) {
+        alloc_free(image->alloc, image->map);
+    }
+
+    return result;
+}
+
+static void _rb_tree_image_unmap(rb_tree_image_t *image) {
+    alloc_free(image->alloc, image->map);
+}
+
+#endif
+
+/*Strictly ascending elements, what search and rb_tree_build_sorted rely on*/
+static bool _rb_tree_image_sorted(rb_tree_image_t *image) {
+    for (uint32_t i = 1; i < image->size; ++i) {
+        if (image->compare(AT(image, i - 1), AT(image, i)) >= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+rb_tree_image_t *rb_tree_load_mapped_via(const alloc_t *alloc, const char *path, cmp_f compare, uint32_t typeSize) {
+    ASSERT_ERROR(path, TAG, "NULL path") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(compare, TAG, "NULL comparator") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(typeSize, TAG, "Zero type size") {
+        return NULL;
+    }
+
+    rb_tree_image_t *image = alloc_malloc(alloc, sizeof(rb_tree_image_t));
+
+    ASSERT_ERROR(image, TAG, "Can't allocate memory for image") {
+        return NULL;
+    }
+
+    image->alloc = alloc;
+    image->compare = compare;
+
+    if (!_rb_tree_image_map(image, path)) {
+        alloc_free(alloc, image);
+        return NULL;
+    }
+
+    /*Files are outside input, so these checks stay in release builds*/
+    const image_header_t *header = image->map;
+    const bool valid = image->mapSize >= sizeof(image_header_t) &&
+                       header->magic == IMAGE_MAGIC &&
+                       header->version == IMAGE_VERSION &&
+                       header->endian == IMAGE_ENDIAN &&
+                       header->typeSize == typeSize &&
+                       image->mapSize == sizeof(image_header_t) + (uint64_t)header->count * typeSize;
+
+    if (!valid) {
+        _rb_tree_image_unmap(image);
+        alloc_free(alloc, image);
+        return NULL;
+    }
+
+    image->data = (const image_header_t *)image->map + 1;
+    image->typeSize = typeSize;
+    image->size = header->count;
+
+    return image;
+}
+
+bool rb_tree_image_verify(rb_tree_image_t *image) {
+    ASSERT_ERROR(image, TAG, "NULL image") {
+        return false;
+    }
+
+    return _rb_tree_image_sorted(image);
+}
+
+bool rb_tree_load(rb_tree_t *tree, const char *path) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return false;
+    }
+
+    rb_tree_image_t *image = rb_tree_load_mapped_via(NULL, path, rb_tree_compare(tree), rb_tree_type_size(tree));
+
+    if (!image) {
+        return false;
+    }
+
+    /*Every element is copied anyway, so the order check costs no extra page faults*/
+    const bool result = _rb_tree_image_sorted(image) && rb_tree_build_sorted(tree, image->data, image->size);
+
+    rb_tree_image_term(image);
+    return result;
+}
+
+void rb_tree_image_term(rb_tree_image_t *image) {
+    ASSERT_ERROR(image, TAG, "NULL image") {
+        return;
+    }
+
+    _rb_tree_image_unmap(image);
+    alloc_free(image->alloc, image);
+}
+
+/*Index of the first element not less than ptr, or of the first greater one when upper is set*/
+static uint32_t _rb_tree_image_bound(rb_tree_image_t *image, const void *ptr, bool upper) {
+    uint32_t left = 0;
+    uint32_t right = image->size;
+    while (left < right) {
+        const uint32_t middle = left + (right - left) / 2;
+        const int32_t cmpr = image->compare(AT(image, middle), ptr);
+        if (cmpr < 0 || (upper && !cmpr)) {
+            left = middle + 1;
+        } else {
+            right = middle;
+        }
+    }
+    return left;
+}
+
+const void *rb_tree_image_find(rb_tree_image_t *image, const void *ptr) {
+    ASSERT_ERROR(image, TAG, "NULL image") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    const uint32_t index = _rb_tree_image_bound(image, ptr, false);
+    return index < image->size && !image->compare(AT(image, index), ptr) ? AT(image, index) : NULL;
+}
+
+const void *rb_tree_image_min(rb_tree_image_t *image, const void *ptr) {
+    ASSERT_ERROR(image, TAG, "NULL image") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    const uint32_t index = _rb_tree_image_bound(image, ptr, false);
+    return index < image->size ? AT(image, index) : NULL;
+}
+
+const void *rb_tree_image_max(rb_tree_image_t *image, const void *ptr) {
+    ASSERT_ERROR(image, TAG, "NULL image") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    const uint32_t index = _rb_tree_image_bound(image, ptr, true);
+    return index ? AT(image, index - 1) : NULL;
+}
+
+const void *rb_tree_image_at(rb_tree_image_t *image, uint32_t index) {
+    ASSERT_ERROR(image, TAG, "NULL image") {
+        return NULL;
+    }
+
+    return index < image->size ? AT(image, index) : NULL;
+}
+
+const void *rb_tree_image_data(rb_tree_image_t *image) {
+    ASSERT_ERROR(image, TAG, "NULL image") {
+        return NULL;
+    }
+
+    return image->data;
+}
+
+uint32_t rb_tree_image_size(rb_tree_image_t *image) {
+    ASSERT_ERROR(image, TAG, "NULL image") {
+        return 0;
+    }
+
+    return image->size;
+}
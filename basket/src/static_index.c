@@ -0,0 +1,228 @@
+#include "meal/static_index.h"
+
+#include "meal/assert.h"
+#include "meal/memory.h"
+#include "meal/macros.h"
+#include "rb_tree.h"
+
+#define TAG "Static Index"
+
+/*Descendants of k four levels down are 16k..16k+15, they are fetched while comparing with k*/
+#define PREFETCH_LEVELS 4
+
+/*Eytzinger layout: element k has children 2k and 2k+1, slot 0 is unused*/
+typedef struct static_index_t {
+    const alloc_t *alloc;
+    cmp_f compare;
+    void *data;
+    uint32_t typeSize;
+    uint32_t size;
+} static_index_t;
+
+#define AT(index, pos) ((index)->data + (uint64_t)(pos) * (index)->typeSize)
+
+static uint32_t _static_index_first(uint32_t size) {
+    uint64_t pos = size ? 1 : 0;
+    while (pos && pos * 2 <= size) {
+        pos *= 2;
+    }
+    return pos;
+}
+
+/*In-order successor: leftmost of right subtree, or first ancestor reached from the left*/
+static uint32_t _static_index_next(uint32_t pos, uint32_t size) {
+    uint64_t next = (uint64_t)pos * 2 + 1;
+    if (next <= size) {
+        while (next * 2 <= size) {
+            next *= 2;
+        }
+        return next;
+    }
+
+    while (pos & 1) {
+        pos >>= 1;
+    }
+    return pos >> 1;
+}
+
+typedef struct fill_t {
+    static_index_t *index;
+    uint32_t pos;
+} fill_t;
+
+static void _static_index_fill(void *ptr, void *data) {
+    fill_t *fill = data;
+    mem_copy(AT(fill->index, fill->pos), ptr, fill->index->typeSize);
+    fill->pos = _static_index_next(fill->pos, fill->index->size);
+}
+
+static_index_t *static_index_init_via(const alloc_t *alloc, rb_tree_t *tree) {
+    ASSERT_ERROR(tree, TAG, "NULL tree") {
+        return NULL;
+    }
+
+    static_index_t *index = alloc_malloc(alloc, sizeof(static_index_t));
+
+    ASSERT_ERROR(index, TAG, "Can't allocate memory for index") {
+        return NULL;
+    }
+
+    index->alloc = alloc;
+    index->compare = rb_tree_compare(tree);
+    index->typeSize = rb_tree_type_size(tree);
+    index->size = rb_tree_size(tree);
+    index->data = alloc_malloc(alloc, (uint64_t)(index->size + 1) * index->typeSize);
+
+    ASSERT_ERROR(index->data, TAG, "Can't allocate memory for index data") {
+        alloc_free(alloc, index);
+        return NULL;
+    }
+
+    fill_t fill = {index, _static_index_first(index->size)};
+    rb_tree_foreach(tree, _static_index_fill, &fill);
+
+    return index;
+}
+
+void static_index_term(static_index_t *index) {
+    ASSERT_ERROR(index, TAG, "NULL index") {
+        return;
+    }
+
+    alloc_free(index->alloc, index->data);
+    alloc_free(index->alloc, index);
+}
+
+/*Comparison result picks the child without a branch; the path bits record every turn,*/
+/*so the answer is the last node where the descent went left*/
+static uint32_t _static_index_lower(static_index_t *index, const void *ptr) {
+    uint64_t pos = 1;
+    while (pos <= index->size) {
+        PREFETCH(AT(index, pos << PREFETCH_LEVELS));
+        pos = pos * 2 + (index->compare(AT(index, pos), ptr) < 0);
+    }
+
+    while (pos & 1) {
+        pos >>= 1;
+    }
+    return pos >> 1;
+}
+
+/*Same descent going right on equality, answer is the last node where it went right*/
+static uint32_t _static_index_upper(static_index_t *index, const void *ptr) {
+    uint64_t pos = 1;
+    while (pos <= index->size) {
+        PREFETCH(AT(index, pos << PREFETCH_LEVELS));
+        pos = pos * 2 + (index->compare(AT(index, pos), ptr) <= 0);
+    }
+
+    while (pos && !(pos & 1)) {
+        pos >>= 1;
+    }
+    return pos >> 1;
+}
+
+const void *static_index_find(static_index_t *index, const void *ptr) {
+    ASSERT_ERROR(index, TAG, "NULL index") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    const uint32_t pos = _static_index_lower(index, ptr);
+    return pos && !index->compare(AT(index, pos), ptr) ? AT(index, pos) : NULL;
+}
+
+const void *static_index_min(static_index_t *index, const void *ptr) {
+    ASSERT_ERROR(index, TAG, "NULL index") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    const uint32_t pos = _static_index_lower(index, ptr);
+    return pos ? AT(index, pos) : NULL;
+}
+
+const void *static_index_max(static_index_t *index, const void *ptr) {
+    ASSERT_ERROR(index, TAG, "NULL index") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    const uint32_t pos = _static_index_upper(index, ptr);
+    return pos ? AT(index, pos) : NULL;
+}
+
+const void *static_index_begin_iter_tmp(static_index_t *index, static_index_iter_s *iter) {
+    ASSERT_ERROR(index, TAG, "NULL index") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    iter->index = index;
+    iter->pos = _static_index_first(index->size);
+
+    return iter->pos ? AT(index, iter->pos) : NULL;
+}
+
+const void *static_index_min_iter_tmp(static_index_t *index, const void *ptr, static_index_iter_s *iter) {
+    ASSERT_ERROR(index, TAG, "NULL index") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(ptr, TAG, "NULL data") {
+        return NULL;
+    }
+
+    ASSERT_ERROR(iter, TAG, "NULL iterator") {
+        return NULL;
+    }
+
+    iter->index = index;
+    iter->pos = _static_index_lower(index, ptr);
+
+    return iter->pos ? AT(index, iter->pos) : NULL;
+}
+
+const void *static_index_iter_tmp_next(static_index_iter_s *iter) {
+    ASSERT_ERROR(iter && iter->pos, TAG, "Iterator is out of range") {
+        return NULL;
+    }
+
+    iter->pos = _static_index_next(iter->pos, iter->index->size);
+
+    return iter->pos ? AT(iter->index, iter->pos) : NULL;
+}
+
+void static_index_foreach(static_index_t *index, const_action_f func, void *data) {
+    ASSERT_ERROR(index, TAG, "NULL index") {
+        return;
+    }
+
+    ASSERT_ERROR(func, TAG, "NULL function") {
+        return;
+    }
+
+    for (uint32_t pos = _static_index_first(index->size); pos; pos = _static_index_next(pos, index->size)) {
+        func(AT(index, pos), data);
+    }
+}
+
+uint32_t static_index_size(static_index_t *index) {
+    ASSERT_ERROR(index, TAG, "NULL index") {
+        return 0;
+    }
+
+    return index->size;
+}
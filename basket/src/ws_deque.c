@@ -0,0 +1,286 @@
+#include "meal/ws_deque.h"
+
+#include "meal/assert.h"
+
+#include <stdatomic.h>
+
+#define TAG "WS Deque"
+
+#define SEGMENTS_COUNT 4
+
+#define CACHE_LINE 64
+
+typedef struct segments_t segments_t;
+
+/*Ring of leaf buffers; task index i lives in buffer (i >> shift) & mask*/
+typedef struct segments_t {
+    segments_t *retired;
+    uint32_t count;
+    uint32_t mask;
+    _Atomic(void *) *data[];
+} segments_t;
+
+typedef struct ws_deque_t {
+    const alloc_t *alloc;
+    uint32_t bufferShift;
+    uint32_t bufferMask;
+    _Atomic(segments_t *) segments;
+    char padTop[CACHE_LINE];
+    atomic_int_fast64_t top;
+    char padBottom[CACHE_LINE];
+    atomic_int_fast64_t bottom;
+    char padEnd[CACHE_LINE];
+} ws_deque_t;
+
+#define SLOT(deque, segments, index)\
+(segments->data[((uint64_t)(index) >> deque->bufferShift) & segments->mask][(index) & deque->bufferMask])
+
+#define CAPACITY(deque, segments) ((int64_t)segments->count << deque->bufferShift)
+
+static uint32_t _ws_deque_log2(uint32_t value) {
+    uint32_t shift = 0;
+    while ((1u << shift) < value) {
+        shift++;
+    }
+    return shift;
+}
+
+static segments_t *_ws_deque_segments_new(const alloc_t *alloc, uint32_t count) {
+    segments_t *segments = alloc_malloc(alloc, sizeof(segments_t) + sizeof(_Atomic(void *) *) * count);
+
+    ASSERT_ERROR(segments, TAG, "Can't allocate memory for deque segments") {
+        return NULL;
+    }
+
+    segments->retired = NULL;
+    segments->count = count;
+    segments->mask = count - 1;
+
+    for (uint32_t i = 0; i < count; i++) {
+        segments->data[i] = NULL;
+    }
+
+    return segments;
+}
+
+static void _ws_deque_segments_term(const alloc_t *alloc, segments_t *segments) {
+    for (uint32_t i = 0; i < segments->count; i++) {
+        if (segments->data[i]) {
+            alloc_free(alloc, segments->data[i]);
+        }
+    }
+
+    while (segments) {
+        segments_t *tmp = segments;
+        segments = segments->retired;
+        alloc_free(alloc, tmp);
+    }
+}
+
+static bool _ws_deque_segments_fill(ws_deque_t *deque, segments_t *segments) {
+    for (uint32_t i = 0; i < segments->count; i++) {
+        if (!segments->data[i]) {
+            segments->data[i] = alloc_malloc(deque->alloc, sizeof(_Atomic(void *)) << deque->bufferShift);
+
+            ASSERT_ERROR(segments->data[i], TAG, "Can't allocate memory for deque data") {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+ws_deque_t *ws_deque_init_via(const alloc_t *alloc, uint32_t bufferSize) {
+    ASSERT_ERROR(bufferSize > 1 && bufferSize <= (1u << 31), TAG, "BufferSize must be in (1; 2^31]: "
+                                                                  "bufferSize = %u", bufferSize) {
+        return NULL;
+    }
+
+    ws_deque_t *deque = alloc_malloc(alloc, sizeof(ws_deque_t));
+
+    ASSERT_ERROR(deque, TAG, "Can't allocate memory for deque") {
+        return NULL;
+    }
+
+    deque->alloc = alloc;
+    deque->bufferShift = _ws_deque_log2(bufferSize);
+    deque->bufferMask = (1u << deque->bufferShift) - 1;
+
+    segments_t *segments = _ws_deque_segments_new(alloc, SEGMENTS_COUNT);
+
+    if (!segments) {
+        alloc_free(alloc, deque);
+        return NULL;
+    }
+
+    if (!_ws_deque_segments_fill(deque, segments)) {
+        _ws_deque_segments_term(alloc, segments);
+        alloc_free(alloc, deque);
+        return NULL;
+    }
+
+    atomic_init(&deque->segments, segments);
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+
+    return deque;
+}
+
+void ws_deque_term(ws_deque_t *deque) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return;
+    }
+
+    _ws_deque_segments_term(deque->alloc, atomic_load_explicit(&deque->segments, memory_order_relaxed));
+    alloc_free(deque->alloc, deque);
+}
+
+/*Doubles the ring moving buffer pointers only: every buffer keeping live tasks*/
+/*is placed where the new mask expects it, so tasks are never copied.*/
+/*Old ring stays valid for late thieves until term.*/
+static segments_t *_ws_deque_grow(ws_deque_t *deque, segments_t *old, int64_t top, int64_t bottom) {
+    ASSERT_ERROR(old->count <= UINT32_MAX / 2, TAG, "Deque is too big: count = %u", old->count) {
+        return NULL;
+    }
+
+    segments_t *segments = _ws_deque_segments_new(deque->alloc, old->count * 2);
+
+    if (!segments) {
+        return NULL;
+    }
+
+    const uint64_t first = (uint64_t)top >> deque->bufferShift;
+    const uint64_t last = (uint64_t)bottom >> deque->bufferShift;
+
+    for (uint64_t i = first; i <= last; i++) {
+        segments->data[i & segments->mask] = old->data[i & old->mask];
+    }
+
+    /*Buffers without live tasks take free places*/
+    uint32_t place = 0;
+    for (uint32_t i = 0; i < old->count; i++) {
+        if (((i - first) & old->mask) <= last - first) {
+            continue;
+        }
+
+        while (segments->data[place]) {
+            place++;
+        }
+        segments->data[place] = old->data[i];
+    }
+
+    if (!_ws_deque_segments_fill(deque, segments)) {
+        /*Returning borrowed buffers before release*/
+        for (uint32_t i = 0; i < old->count; i++) {
+            for (uint32_t j = 0; j < segments->count; j++) {
+                if (segments->data[j] == old->data[i]) {
+                    segments->data[j] = NULL;
+                }
+            }
+        }
+        _ws_deque_segments_term(deque->alloc, segments);
+        return NULL;
+    }
+
+    segments->retired = old;
+    atomic_store_explicit(&deque->segments, segments, memory_order_release);
+
+    return segments;
+}
+
+bool ws_deque_push(ws_deque_t *deque, void *task) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return false;
+    }
+
+    ASSERT_ERROR(task, TAG, "NULL task") {
+        return false;
+    }
+
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    segments_t *segments = atomic_load_explicit(&deque->segments, memory_order_relaxed);
+
+    /*Growing one buffer early, so live tasks never share a buffer with the slot being written*/
+    if (bottom - top >= CAPACITY(deque, segments) - ((int64_t)1 << deque->bufferShift)) {
+        segments = _ws_deque_grow(deque, segments, top, bottom);
+
+        if (!segments) {
+            return false;
+        }
+    }
+
+    atomic_store_explicit(&SLOT(deque, segments, bottom), task, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+    return true;
+}
+
+void *ws_deque_pop(ws_deque_t *deque) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return NULL;
+    }
+
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    segments_t *segments = atomic_load_explicit(&deque->segments, memory_order_relaxed);
+
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    void *task = NULL;
+
+    if (top <= bottom) {
+        task = atomic_load_explicit(&SLOT(deque, segments, bottom), memory_order_relaxed);
+
+        if (top == bottom) {
+            /*Last task, racing with thieves*/
+            if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                         memory_order_seq_cst, memory_order_relaxed)) {
+                task = NULL;
+            }
+            atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+
+    return task;
+}
+
+void *ws_deque_steal(ws_deque_t *deque) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return NULL;
+    }
+
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if (top >= bottom) {
+        return NULL;
+    }
+
+    segments_t *segments = atomic_load_explicit(&deque->segments, memory_order_acquire);
+    void *task = atomic_load_explicit(&SLOT(deque, segments, top), memory_order_relaxed);
+
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        return NULL;
+    }
+
+    return task;
+}
+
+uint32_t ws_deque_size(ws_deque_t *deque) {
+    ASSERT_ERROR(deque, TAG, "NULL deque") {
+        return 0;
+    }
+
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    return bottom > top ? (uint32_t)(bottom - top) : 0;
+}
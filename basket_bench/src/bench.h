@@ -0,0 +1,26 @@
+#ifndef MEAL_BASKET_BENCH_H
+#define MEAL_BASKET_BENCH_H
+
+#include <stdint.h>
+
+#define BENCH_REPEATS 5
+
+double bench_now(void);
+
+#define BENCH_BEST(best, statement)\
+do {\
+    double __START = bench_now();\
+    statement;\
+    double __TIME = bench_now() - __START;\
+    if (__TIME < best) {\
+        best = __TIME;\
+    }\
+} while (0)
+
+void hash_stack_bench(void);
+
+void ws_deque_bench(void);
+
+void bp_tree_bench(void);
+
+#endif //MEAL_BASKET_BENCH_H
@@ -0,0 +1,75 @@
+#include "bench.h"
+
+#include "meal/rb_tree.h"
+#include "meal/bp_tree.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FINDS 2000000
+
+#define NODE_SIZE 256
+
+static int32_t _bp_tree_bench_compare(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void _bp_tree_bench_sum(void *ptr, void *data) {
+    *(uint64_t *)data += *(uint32_t *)ptr;
+}
+
+/*Same random keys go through both trees, every phase is timed per operation*/
+static void _bp_tree_bench_run(uint32_t count) {
+    uint32_t *keys = malloc(count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) {
+        keys[i] = i * 2654435761u;
+    }
+
+    rb_tree_t *rb = rb_tree_init(_bp_tree_bench_compare, sizeof(uint32_t), 4096);
+    bp_tree_t *bp = bp_tree_init(_bp_tree_bench_compare, sizeof(uint32_t), NODE_SIZE);
+
+    double rbInsert = 1e9, bpInsert = 1e9, rbFind = 1e9, bpFind = 1e9;
+    double rbScan = 1e9, bpScan = 1e9, rbRemove = 1e9, bpRemove = 1e9;
+    uint64_t sum = 0;
+
+    BENCH_BEST(rbInsert, for (uint32_t i = 0; i < count; i++) {
+        rb_tree_insert(rb, &keys[i]);
+    });
+    BENCH_BEST(bpInsert, for (uint32_t i = 0; i < count; i++) {
+        bp_tree_insert(bp, &keys[i]);
+    });
+
+    BENCH_BEST(rbFind, for (uint32_t i = 0; i < FINDS; i++) {
+        sum += (uintptr_t)rb_tree_find(rb, &keys[(i * 7919u) % count]);
+    });
+    BENCH_BEST(bpFind, for (uint32_t i = 0; i < FINDS; i++) {
+        sum += (uintptr_t)bp_tree_find(bp, &keys[(i * 7919u) % count]);
+    });
+
+    BENCH_BEST(rbScan, rb_tree_foreach(rb, _bp_tree_bench_sum, &sum));
+    BENCH_BEST(bpScan, bp_tree_foreach(bp, _bp_tree_bench_sum, &sum));
+
+    BENCH_BEST(rbRemove, for (uint32_t i = 0; i < count; i++) {
+        rb_tree_remove(rb, &keys[(i * 7919u) % count], NULL);
+    });
+    BENCH_BEST(bpRemove, for (uint32_t i = 0; i < count; i++) {
+        bp_tree_remove(bp, &keys[(i * 7919u) % count], NULL);
+    });
+
+    printf("  n = %8u rb / bp ns/op: insert %.0f / %.0f, find %.0f / %.0f, scan %.1f / %.1f, remove %.0f / %.0f (%u)\n",
+           count, rbInsert * 1e9 / count, bpInsert * 1e9 / count, rbFind * 1e9 / FINDS, bpFind * 1e9 / FINDS,
+           rbScan * 1e9 / count, bpScan * 1e9 / count, rbRemove * 1e9 / count, bpRemove * 1e9 / count,
+           (uint32_t)(sum & 1));
+
+    rb_tree_term(rb);
+    bp_tree_term(bp);
+    free(keys);
+}
+
+void bp_tree_bench(void) {
+    _bp_tree_bench_run(1000);
+    _bp_tree_bench_run(1000000);
+    _bp_tree_bench_run(4000000);
+}
@@ -0,0 +1,41 @@
+#include "bench.h"
+
+#include "meal/hash_stack.h"
+
+#include <stdio.h>
+
+#define COUNT 20000000
+
+/*1024 takes digits by shift and mask, 1000 by division*/
+static void _hash_stack_bench_run(uint32_t bufferSize) {
+    double push = 1e9, peek = 1e9, at = 1e9;
+    uint64_t sum = 0;
+
+    for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        hash_stack_t *stack = hash_stack_init(sizeof(uint32_t), bufferSize);
+
+        BENCH_BEST(push, for (uint32_t i = 0; i < COUNT; i++) {
+            hash_stack_push(stack, &i);
+        });
+
+        BENCH_BEST(peek, for (uint32_t i = 1; i <= COUNT; i++) {
+            sum += *(uint32_t *)hash_stack_peek_offset(stack, i);
+        });
+
+        uint32_t random = 1;
+        BENCH_BEST(at, for (uint32_t i = 0; i < COUNT; i++) {
+            random = random * 1664525u + 1013904223u;
+            sum += *(uint32_t *)hash_stack_at(stack, random % COUNT);
+        });
+
+        hash_stack_term(stack);
+    }
+
+    printf("  bufferSize %4u: push %.2f, peek %.2f, random at %.2f ns/op (%u)\n", bufferSize,
+           push * 1e9 / COUNT, peek * 1e9 / COUNT, at * 1e9 / COUNT, (uint32_t)(sum & 1));
+}
+
+void hash_stack_bench(void) {
+    _hash_stack_bench_run(1000);
+    _hash_stack_bench_run(1024);
+}
@@ -0,0 +1,44 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "bench.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct bench_t {
+    const char *name;
+    void (*run)(void);
+} bench_t;
+
+static const bench_t benches[] = {
+        {"hash_stack", hash_stack_bench},
+        {"ws_deque",   ws_deque_bench},
+        {"bp_tree",    bp_tree_bench},
+};
+
+#define BENCH_COUNT (sizeof(benches) / sizeof(bench_t))
+
+double bench_now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+/*Without arguments every benchmark runs, otherwise only the named ones*/
+int main(int argc, char **argv) {
+    for (uint32_t i = 0; i < BENCH_COUNT; i++) {
+        bool selected = argc < 2;
+        for (int32_t j = 1; j < argc && !selected; j++) {
+            selected = !strcmp(argv[j], benches[i].name);
+        }
+
+        if (selected) {
+            printf("%s\n", benches[i].name);
+            benches[i].run();
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "bench.h"
+
+#include "meal/ws_deque.h"
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#define TASKS 4000000
+
+#define MAX_THIEVES 8
+
+/*Owner keeps the deque short, so thieves mostly race for the same top task*/
+#define BACKLOG 64
+
+/*Spinning threads yield now and then, or an oversubscribed machine crawls*/
+#define SPINS 64
+
+typedef struct contention_t {
+    ws_deque_t *deque;
+    atomic_uint stolen;
+    atomic_ulong misses;
+} contention_t;
+
+static void *_ws_deque_bench_thief(void *data) {
+    contention_t *contention = data;
+    uint64_t misses = 0;
+    uint32_t spins = 0;
+    while (atomic_load_explicit(&contention->stolen, memory_order_relaxed) < TASKS) {
+        if (ws_deque_steal(contention->deque)) {
+            atomic_fetch_add_explicit(&contention->stolen, 1, memory_order_relaxed);
+            spins = 0;
+        } else {
+            misses++;
+            if (++spins == SPINS) {
+                sched_yield();
+                spins = 0;
+            }
+        }
+    }
+    atomic_fetch_add_explicit(&contention->misses, misses, memory_order_relaxed);
+    return NULL;
+}
+
+static void _ws_deque_bench_run(uint32_t thieves) {
+    static uint32_t task;
+
+    contention_t contention;
+    contention.deque = ws_deque_init(1024);
+    atomic_init(&contention.stolen, 0);
+    atomic_init(&contention.misses, 0);
+
+    const double start = bench_now();
+
+    pthread_t threads[MAX_THIEVES];
+    for (uint32_t i = 0; i < thieves; i++) {
+        pthread_create(&threads[i], NULL, _ws_deque_bench_thief, &contention);
+    }
+
+    for (uint32_t pushed = 0; pushed < TASKS; pushed++) {
+        for (uint32_t spins = 1; ws_deque_size(contention.deque) >= BACKLOG; spins++) {
+            if (spins % SPINS == 0) {
+                sched_yield();
+            }
+        }
+        ws_deque_push(contention.deque, &task);
+    }
+
+    for (uint32_t i = 0; i < thieves; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    const double time = bench_now() - start;
+    printf("  %u thieves: %.1f ns/task, %.2f failed steals per task\n", thieves, time * 1e9 / TASKS,
+           (double)atomic_load(&contention.misses) / TASKS);
+
+    ws_deque_term(contention.deque);
+}
+
+void ws_deque_bench(void) {
+    for (uint32_t thieves = 1; thieves <= MAX_THIEVES; thieves *= 2) {
+        _ws_deque_bench_run(thieves);
+    }
+}
@@ -0,0 +1,173 @@
+#include "test.h"
+
+#include "meal/bp_tree.h"
+
+#include <stdlib.h>
+
+#define KEYS 4096
+
+#define STEPS 200000
+
+#define CHECK_EVERY 128
+
+static int32_t _bp_tree_test_compare(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*Leaf scans both ways, pool iterators, size and bounds must all agree with the model*/
+static bool _bp_tree_test_check(bp_tree_t *tree, const bool *model) {
+    uint32_t count = 0;
+    bp_tree_iter_s iter;
+    const uint32_t *value = bp_tree_begin_iter_tmp(tree, &iter);
+    for (uint32_t key = 0; key < KEYS; key++) {
+        if (!model[key]) {
+            continue;
+        }
+
+        TEST_ASSERT(value && *value == key)
+        count++;
+        value = bp_tree_iter_tmp_next(&iter);
+    }
+
+    TEST_ASSERT(!value)
+    TEST_ASSERT(bp_tree_size(tree) == count)
+
+    const uint32_t last = KEYS;
+    value = bp_tree_max_iter_tmp(tree, &last, &iter);
+    for (uint32_t key = KEYS; key > 0; key--) {
+        if (model[key - 1]) {
+            TEST_ASSERT(value && *value == key - 1)
+            value = bp_tree_iter_tmp_prev(&iter);
+        }
+    }
+    TEST_ASSERT(!value)
+
+    if (count) {
+        iter_t *walk = bp_tree_iter(tree);
+        iter_t *copy = iter_copy(walk);
+        TEST_ASSERT(walk && copy)
+
+        value = bp_tree_begin_iter_tmp(tree, &iter);
+        while (value) {
+            TEST_ASSERT(*(uint32_t *)iter_value(walk) == *value && iter_value(copy) == iter_value(walk))
+            iter_next(walk);
+            iter_next(copy);
+            value = bp_tree_iter_tmp_next(&iter);
+        }
+
+        TEST_ASSERT(!iter_value(walk) && !iter_value(copy))
+        iter_term(walk);
+        iter_term(copy);
+    }
+    return true;
+}
+
+/*Lookups of one key against a scan of the model*/
+static bool _bp_tree_test_find(bp_tree_t *tree, const bool *model, uint32_t key) {
+    uint32_t above = key;
+    while (above < KEYS && !model[above]) {
+        above++;
+    }
+
+    uint32_t below = key + 1;
+    while (below && !model[below - 1]) {
+        below--;
+    }
+
+    const uint32_t *found = bp_tree_find(tree, &key);
+    const uint32_t *min = bp_tree_min(tree, &key);
+    const uint32_t *max = bp_tree_max(tree, &key);
+
+    TEST_ASSERT(model[key] ? found && *found == key : !found)
+    TEST_ASSERT(above < KEYS ? min && *min == above : !min)
+    TEST_ASSERT(below ? max && *max == below - 1 : !max)
+    return true;
+}
+
+static bool _bp_tree_test_model(uint32_t nodeSize, uint32_t seed) {
+    bp_tree_t *tree = bp_tree_init(_bp_tree_test_compare, sizeof(uint32_t), nodeSize);
+    TEST_ASSERT(tree)
+
+    bool model[KEYS] = {false};
+    srand(seed);
+
+    for (uint32_t step = 0; step < STEPS; step++) {
+        uint32_t key = rand() % KEYS;
+        uint32_t out = KEYS;
+
+        switch (rand() % 8) {
+            case 0:
+            case 1:
+            case 2: {
+                TEST_ASSERT((bp_tree_insert(tree, &key) != NULL) == !model[key])
+                model[key] = true;
+                break;
+            }
+            case 3: {
+                TEST_ASSERT(bp_tree_remove(tree, &key, &out) == model[key])
+                TEST_ASSERT(!model[key] || out == key)
+                model[key] = false;
+                break;
+            }
+            case 4: {
+                uint32_t expected = key;
+                while (expected < KEYS && !model[expected]) {
+                    expected++;
+                }
+
+                TEST_ASSERT(bp_tree_remove_min(tree, &key, &out) == (expected < KEYS))
+                if (expected < KEYS) {
+                    TEST_ASSERT(out == expected)
+                    model[expected] = false;
+                }
+                break;
+            }
+            case 5: {
+                uint32_t expected = key + 1;
+                while (expected && !model[expected - 1]) {
+                    expected--;
+                }
+
+                TEST_ASSERT(bp_tree_remove_max(tree, &key, &out) == (expected != 0))
+                if (expected) {
+                    TEST_ASSERT(out == expected - 1)
+                    model[expected - 1] = false;
+                }
+                break;
+            }
+            case 6: {
+                bp_tree_iter_s iter;
+                TEST_ASSERT((bp_tree_iter_tmp(tree, &key, &iter) != NULL) == model[key])
+                TEST_ASSERT(bp_tree_remove_iter_tmp(tree, &iter, &out) == model[key])
+                TEST_ASSERT(!model[key] || out == key)
+                model[key] = false;
+                break;
+            }
+            case 7: {
+                if (!_bp_tree_test_find(tree, model, key)) {
+                    return false;
+                }
+                break;
+            }
+        }
+
+        if (step % CHECK_EVERY == 0 && !_bp_tree_test_check(tree, model)) {
+            return false;
+        }
+    }
+
+    const bool result = _bp_tree_test_check(tree, model);
+    bp_tree_term(tree);
+    return result;
+}
+
+bool bp_tree_test(void) {
+    for (uint32_t seed = 0; seed < 2; seed++) {
+        /*Small nodes split and merge often, bigger ones exercise wide leaves*/
+        TEST_ASSERT(_bp_tree_test_model(128, seed))
+        TEST_ASSERT(_bp_tree_test_model(512, seed))
+    }
+    return true;
+}
@@ -0,0 +1,144 @@
+#include "test.h"
+
+#include "meal/crb_tree.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define READERS 4
+
+#define WRITERS 2
+
+#define KEYS 20000
+
+#define WRITES 200000
+
+#define FIELDS 7
+
+/*Fields are derived from the key, so a torn copy shows up as a mismatch*/
+typedef struct record_t {
+    uint32_t key;
+    uint32_t fields[FIELDS];
+} record_t;
+
+typedef struct stress_t {
+    crb_tree_t *tree;
+    atomic_bool done;
+    atomic_bool failed;
+} stress_t;
+
+typedef struct worker_t {
+    stress_t *stress;
+    uint32_t seed;
+} worker_t;
+
+static int32_t _crb_tree_test_compare(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t _crb_tree_test_random(uint32_t *seed) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+static void _crb_tree_test_fill(record_t *record, uint32_t key) {
+    record->key = key;
+    for (uint32_t i = 0; i < FIELDS; i++) {
+        record->fields[i] = key * FIELDS + i;
+    }
+}
+
+static bool _crb_tree_test_valid(const record_t *record, uint32_t key) {
+    bool valid = record->key == key;
+    for (uint32_t i = 0; i < FIELDS; i++) {
+        valid = valid && record->fields[i] == key * FIELDS + i;
+    }
+    return valid;
+}
+
+/*Even keys are never touched by writers and must always be found*/
+static void *_crb_tree_test_reader(void *data) {
+    worker_t *worker = data;
+    stress_t *stress = worker->stress;
+    while (!atomic_load_explicit(&stress->done, memory_order_relaxed)) {
+        const uint32_t key = _crb_tree_test_random(&worker->seed) % KEYS;
+        record_t record;
+        const bool found = crb_tree_find(stress->tree, &key, &record);
+        if ((found && !_crb_tree_test_valid(&record, key)) || (!found && key % 2 == 0)) {
+            atomic_store_explicit(&stress->failed, true, memory_order_relaxed);
+        }
+    }
+    return NULL;
+}
+
+static void *_crb_tree_test_writer(void *data) {
+    worker_t *worker = data;
+    stress_t *stress = worker->stress;
+    for (uint32_t i = 0; i < WRITES; i++) {
+        record_t record;
+        _crb_tree_test_fill(&record, (_crb_tree_test_random(&worker->seed) % (KEYS / 2)) * 2 + 1);
+
+        if (_crb_tree_test_random(&worker->seed) & 1) {
+            crb_tree_insert(stress->tree, &record);
+        } else {
+            record_t removed;
+            if (crb_tree_remove(stress->tree, &record, &removed) && !_crb_tree_test_valid(&removed, record.key)) {
+                atomic_store_explicit(&stress->failed, true, memory_order_relaxed);
+            }
+        }
+    }
+    return NULL;
+}
+
+/*Readers look up while writers insert and remove odd keys, every copy must be whole*/
+bool crb_tree_test(void) {
+    stress_t stress;
+    stress.tree = crb_tree_init(_crb_tree_test_compare, sizeof(record_t), 1024);
+    atomic_init(&stress.done, false);
+    atomic_init(&stress.failed, false);
+
+    TEST_ASSERT(stress.tree)
+
+    for (uint32_t key = 0; key < KEYS; key += 2) {
+        record_t record;
+        _crb_tree_test_fill(&record, key);
+        TEST_ASSERT(crb_tree_insert(stress.tree, &record))
+    }
+
+    worker_t readers[READERS];
+    pthread_t readerThreads[READERS];
+    for (uint32_t i = 0; i < READERS; i++) {
+        readers[i] = (worker_t) {&stress, i + 1};
+        TEST_ASSERT(!pthread_create(&readerThreads[i], NULL, _crb_tree_test_reader, &readers[i]))
+    }
+
+    worker_t writers[WRITERS];
+    pthread_t writerThreads[WRITERS];
+    for (uint32_t i = 0; i < WRITERS; i++) {
+        writers[i] = (worker_t) {&stress, 100 + i};
+        TEST_ASSERT(!pthread_create(&writerThreads[i], NULL, _crb_tree_test_writer, &writers[i]))
+    }
+
+    for (uint32_t i = 0; i < WRITERS; i++) {
+        pthread_join(writerThreads[i], NULL);
+    }
+
+    atomic_store_explicit(&stress.done, true, memory_order_relaxed);
+    for (uint32_t i = 0; i < READERS; i++) {
+        pthread_join(readerThreads[i], NULL);
+    }
+
+    TEST_ASSERT(!atomic_load(&stress.failed))
+
+    for (uint32_t key = 0; key < KEYS; key += 2) {
+        record_t record;
+        TEST_ASSERT(crb_tree_find(stress.tree, &key, &record) && _crb_tree_test_valid(&record, key))
+    }
+
+    crb_tree_term(stress.tree);
+    return true;
+}
@@ -0,0 +1,123 @@
+#include "test.h"
+
+#include "meal/deque.h"
+
+#include <stdlib.h>
+
+#define CAPACITY 8192
+
+#define STEPS 200000
+
+#define CHECK_EVERY 256
+
+/*Model keeps its elements in the middle of a plain array, so both ends have room*/
+typedef struct model_t {
+    uint32_t values[CAPACITY * 2];
+    uint32_t begin;
+    uint32_t end;
+} model_t;
+
+static bool _deque_test_check(deque_t *deque, const model_t *model) {
+    const uint32_t size = model->end - model->begin;
+    TEST_ASSERT(deque_size(deque) == size)
+
+    for (uint32_t i = 0; i < size; i++) {
+        const uint32_t *value = deque_at(deque, i);
+        TEST_ASSERT(value && *value == model->values[model->begin + i])
+    }
+
+    if (size) {
+        TEST_ASSERT(*(uint32_t *)deque_front(deque) == model->values[model->begin])
+        TEST_ASSERT(*(uint32_t *)deque_back(deque) == model->values[model->end - 1])
+    } else {
+        TEST_ASSERT(!deque_front(deque) && !deque_back(deque))
+    }
+    return true;
+}
+
+/*Runs of pushes and pops at either end cross buffer boundaries both ways*/
+static bool _deque_test_model(uint32_t bufferSize, uint32_t seed) {
+    deque_t *deque = deque_init(sizeof(uint32_t), bufferSize);
+    TEST_ASSERT(deque)
+
+    model_t *model = malloc(sizeof(model_t));
+    TEST_ASSERT(model)
+    model->begin = CAPACITY;
+    model->end = CAPACITY;
+    srand(seed);
+
+    for (uint32_t step = 0; step < STEPS; step++) {
+        const uint32_t size = model->end - model->begin;
+        uint32_t value = rand();
+        uint32_t out = 0;
+
+        switch (rand() % 9) {
+            case 0:
+            case 1: {
+                if (size < CAPACITY - 1 && model->end < CAPACITY * 2) {
+                    const uint32_t *pushed = deque_push_back(deque, &value);
+                    TEST_ASSERT(pushed && *pushed == value)
+                    model->values[model->end++] = value;
+                }
+                break;
+            }
+            case 2:
+            case 3: {
+                if (size < CAPACITY - 1 && model->begin) {
+                    const uint32_t *pushed = deque_push_front(deque, &value);
+                    TEST_ASSERT(pushed && *pushed == value)
+                    model->values[--model->begin] = value;
+                }
+                break;
+            }
+            case 4:
+            case 5: {
+                TEST_ASSERT(deque_pop_back(deque, &out) == (size != 0))
+                if (size) {
+                    TEST_ASSERT(out == model->values[--model->end])
+                }
+                break;
+            }
+            case 6:
+            case 7: {
+                TEST_ASSERT(deque_pop_front(deque, &out) == (size != 0))
+                if (size) {
+                    TEST_ASSERT(out == model->values[model->begin++])
+                }
+                break;
+            }
+            case 8: {
+                if (!(rand() % 64)) {
+                    deque_clear(deque);
+                    model->begin = CAPACITY;
+                    model->end = CAPACITY;
+                }
+                break;
+            }
+        }
+
+        /*Recentering keeps both ends of the model free*/
+        if (model->begin == model->end) {
+            model->begin = CAPACITY;
+            model->end = CAPACITY;
+        }
+
+        if (step % CHECK_EVERY == 0 && !_deque_test_check(deque, model)) {
+            return false;
+        }
+    }
+
+    const bool result = _deque_test_check(deque, model);
+    deque_term(deque);
+    free(model);
+    return result;
+}
+
+bool deque_test(void) {
+    for (uint32_t seed = 0; seed < 2; seed++) {
+        TEST_ASSERT(_deque_test_model(16, seed))
+        TEST_ASSERT(_deque_test_model(10, seed))
+        TEST_ASSERT(_deque_test_model(2, seed))
+    }
+    return true;
+}
@@ -0,0 +1,220 @@
+#include "test.h"
+
+#include "meal/hash_stack.h"
+
+#include <stdlib.h>
+
+#define CAPACITY 20000
+
+#define STEPS 100000
+
+#define CHECK_EVERY 256
+
+#define RESERVE 4096
+
+HASH_STACK_DECLARE(u32_stack, uint32_t)
+
+typedef struct counter_t {
+    uint32_t mallocs;
+} counter_t;
+
+static void *_hash_stack_test_malloc(uint32_t size, void *data) {
+    ((counter_t *)data)->mallocs++;
+    return malloc(size);
+}
+
+static void *_hash_stack_test_realloc(void *ptr, uint32_t size, void *data) {
+    return realloc(ptr, size);
+}
+
+static void _hash_stack_test_free(void *ptr, void *data) {
+    free(ptr);
+}
+
+static const alloc_funcs_t counting = {
+        _hash_stack_test_malloc,
+        _hash_stack_test_realloc,
+        _hash_stack_test_free,
+};
+
+/*Every element is read back by index and by spans*/
+static bool _hash_stack_test_check(hash_stack_t *stack, const uint32_t *model, uint32_t size) {
+    TEST_ASSERT(hash_stack_size(stack) == size)
+
+    for (uint32_t i = 0; i < size; i++) {
+        const uint32_t *value = hash_stack_at(stack, i);
+        TEST_ASSERT(value && *value == model[i])
+    }
+
+    uint32_t index = 0;
+    while (index < size) {
+        uint32_t count = 0;
+        const uint32_t *span = hash_stack_span(stack, index, &count);
+        TEST_ASSERT(span && count)
+        for (uint32_t i = 0; i < count; i++) {
+            TEST_ASSERT(span[i] == model[index + i])
+        }
+        index += count;
+    }
+
+    TEST_ASSERT(!size || *(uint32_t *)hash_stack_peek(stack) == model[size - 1])
+    return true;
+}
+
+/*Random bulk and single operations checked against a plain array*/
+static bool _hash_stack_test_model(uint32_t bufferSize, uint32_t seed) {
+    hash_stack_t *stack = hash_stack_init(sizeof(uint32_t), bufferSize);
+    TEST_ASSERT(stack)
+
+    uint32_t *model = malloc(sizeof(uint32_t) * CAPACITY);
+    uint32_t *buffer = malloc(sizeof(uint32_t) * CAPACITY);
+    TEST_ASSERT(model && buffer)
+
+    uint32_t size = 0;
+    srand(seed);
+
+    for (uint32_t step = 0; step < STEPS; step++) {
+        const uint32_t count = rand() % (bufferSize * 3);
+
+        switch (rand() % 9) {
+            case 0:
+            case 1: {
+                if (size < CAPACITY) {
+                    model[size] = rand();
+                    TEST_ASSERT(hash_stack_push(stack, &model[size]))
+                    size++;
+                }
+                break;
+            }
+            case 2: {
+                if (size < CAPACITY) {
+                    uint32_t *dst = hash_stack_push_uninit(stack);
+                    TEST_ASSERT(dst)
+                    *dst = model[size++] = rand();
+                }
+                break;
+            }
+            case 3: {
+                if (count && size + count <= CAPACITY) {
+                    for (uint32_t i = 0; i < count; i++) {
+                        model[size + i] = rand();
+                    }
+                    TEST_ASSERT(hash_stack_push_n(stack, model + size, count))
+                    size += count;
+                }
+                break;
+            }
+            case 4: {
+                if (size) {
+                    hash_stack_pop(stack);
+                    size--;
+                }
+                break;
+            }
+            case 5: {
+                if (count && count <= size) {
+                    hash_stack_pop_count(stack, count);
+                    size -= count;
+                }
+                break;
+            }
+            case 6: {
+                if (count <= size) {
+                    TEST_ASSERT(hash_stack_pop_into_n(stack, buffer, count))
+                    size -= count;
+                    for (uint32_t i = 0; i < count; i++) {
+                        TEST_ASSERT(buffer[i] == model[size + i])
+                    }
+                }
+                break;
+            }
+            case 7: {
+                if (size + count <= CAPACITY) {
+                    TEST_ASSERT(hash_stack_reserve(stack, count))
+                }
+                break;
+            }
+            case 8: {
+                if (!(rand() % 8)) {
+                    hash_stack_shrink(stack);
+                }
+                break;
+            }
+        }
+
+        if (step % CHECK_EVERY == 0 && !_hash_stack_test_check(stack, model, size)) {
+            return false;
+        }
+    }
+
+    const bool result = _hash_stack_test_check(stack, model, size);
+    hash_stack_term(stack);
+    free(model);
+    free(buffer);
+    return result;
+}
+
+/*Reserved leaf buffers must survive auto shrink, otherwise every refill allocates again*/
+static bool _hash_stack_test_reserve(uint32_t bufferSize) {
+    counter_t counter = {0};
+    alloc_t *alloc = alloc_init_via(NULL, &counting, &counter);
+    TEST_ASSERT(alloc)
+
+    hash_stack_t *stack = hash_stack_init_via(alloc, sizeof(uint32_t), bufferSize);
+    TEST_ASSERT(stack)
+    TEST_ASSERT(hash_stack_reserve(stack, RESERVE))
+
+    const uint32_t reserved = counter.mallocs;
+    for (uint32_t round = 0; round < 8; round++) {
+        for (uint32_t i = 0; i < RESERVE; i++) {
+            TEST_ASSERT(hash_stack_push(stack, &i))
+        }
+
+        for (uint32_t i = RESERVE; i > 0; i--) {
+            TEST_ASSERT(*(uint32_t *)hash_stack_peek(stack) == i - 1)
+            hash_stack_pop(stack);
+        }
+    }
+    TEST_ASSERT(counter.mallocs == reserved)
+
+    /*Explicit shrink gives the reserve back, so next fill allocates again*/
+    hash_stack_shrink(stack);
+    for (uint32_t i = 0; i < RESERVE; i++) {
+        TEST_ASSERT(hash_stack_push(stack, &i))
+    }
+    TEST_ASSERT(counter.mallocs > reserved)
+
+    hash_stack_term(stack);
+    alloc_term(alloc);
+    return true;
+}
+
+static bool _hash_stack_test_typed(void) {
+    u32_stack_t *stack = u32_stack_init(16);
+    TEST_ASSERT(stack)
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        TEST_ASSERT(u32_stack_push(stack, i) && *u32_stack_at(stack, i) == i)
+    }
+
+    uint32_t value = 0;
+    for (uint32_t i = 1000; i > 0; i--) {
+        TEST_ASSERT(u32_stack_pop(stack, &value) && value == i - 1)
+    }
+
+    TEST_ASSERT(!u32_stack_size(stack))
+    u32_stack_term(stack);
+    return true;
+}
+
+bool hash_stack_test(void) {
+    for (uint32_t seed = 0; seed < 2; seed++) {
+        TEST_ASSERT(_hash_stack_test_model(16, seed))
+        TEST_ASSERT(_hash_stack_test_model(10, seed))
+    }
+
+    TEST_ASSERT(_hash_stack_test_reserve(16))
+    TEST_ASSERT(_hash_stack_test_reserve(10))
+    TEST_ASSERT(_hash_stack_test_typed())
+    return true;
+}
@@ -0,0 +1,46 @@
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+
+typedef struct test_t {
+    const char *name;
+    bool (*run)(void);
+} test_t;
+
+static const test_t tests[] = {
+        {"hash_stack",       hash_stack_test},
+        {"deque",            deque_test},
+        {"ws_deque",         ws_deque_test},
+        {"rb_tree_remove",   rb_tree_remove_test},
+        {"rb_tree_split",    rb_tree_split_test},
+        {"rb_tree_compact",  rb_tree_compact_test},
+        {"rb_tree_parallel", rb_tree_parallel_test},
+        {"rb_tree_image",    rb_tree_image_test},
+        {"static_index",     static_index_test},
+        {"rb_link",          rb_link_test},
+        {"prb_tree",         prb_tree_test},
+        {"bp_tree",          bp_tree_test},
+        {"crb_tree",         crb_tree_test},
+};
+
+#define TEST_COUNT (sizeof(tests) / sizeof(test_t))
+
+/*Without arguments every test runs, otherwise only the named ones*/
+int main(int argc, char **argv) {
+    uint32_t failed = 0;
+    for (uint32_t i = 0; i < TEST_COUNT; i++) {
+        bool selected = argc < 2;
+        for (int32_t j = 1; j < argc && !selected; j++) {
+            selected = !strcmp(argv[j], tests[i].name);
+        }
+
+        if (selected) {
+            const bool passed = tests[i].run();
+            printf("%s: %s\n", tests[i].name, passed ? "passed" : "FAILED");
+            failed += !passed;
+        }
+    }
+
+    return failed != 0;
+}
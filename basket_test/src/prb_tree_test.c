@@ -0,0 +1,167 @@
+#include "test.h"
+
+#include "meal/prb_tree.h"
+
+#include <stdlib.h>
+
+#define KEYS 1024
+
+#define STEPS 100000
+
+#define SNAPSHOTS 8
+
+#define CHECK_EVERY 64
+
+typedef struct version_t {
+    prb_snapshot_t *snapshot;
+    bool model[KEYS];
+} version_t;
+
+typedef struct walk_t {
+    const bool *model;
+    uint32_t next;
+    uint32_t count;
+    bool ordered;
+} walk_t;
+
+static int32_t _prb_tree_test_compare(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*Each visited key must be the next present one of the model*/
+static void _prb_tree_test_walk(const void *ptr, void *data) {
+    walk_t *walk = data;
+    while (walk->next < KEYS && !walk->model[walk->next]) {
+        walk->next++;
+    }
+
+    walk->ordered = walk->ordered && walk->next == *(const uint32_t *)ptr;
+    walk->next++;
+    walk->count++;
+}
+
+static uint32_t _prb_tree_test_count(const bool *model) {
+    uint32_t count = 0;
+    for (uint32_t key = 0; key < KEYS; key++) {
+        count += model[key];
+    }
+    return count;
+}
+
+/*Snapshot must keep showing the model it was taken from, whatever the writer did since*/
+static bool _prb_tree_test_snapshot(const version_t *version, uint32_t key) {
+    walk_t walk = {version->model, 0, 0, true};
+    prb_snapshot_foreach(version->snapshot, _prb_tree_test_walk, &walk);
+    TEST_ASSERT(walk.ordered && walk.count == _prb_tree_test_count(version->model))
+    TEST_ASSERT(prb_snapshot_size(version->snapshot) == walk.count)
+
+    uint32_t above = key;
+    while (above < KEYS && !version->model[above]) {
+        above++;
+    }
+
+    uint32_t below = key + 1;
+    while (below && !version->model[below - 1]) {
+        below--;
+    }
+
+    const uint32_t *found = prb_snapshot_find(version->snapshot, &key);
+    const uint32_t *min = prb_snapshot_min(version->snapshot, &key);
+    const uint32_t *max = prb_snapshot_max(version->snapshot, &key);
+
+    TEST_ASSERT(version->model[key] ? found && *found == key : !found)
+    TEST_ASSERT(above < KEYS ? min && *min == above : !min)
+    TEST_ASSERT(below ? max && *max == below - 1 : !max)
+    return true;
+}
+
+static bool _prb_tree_test_model(uint32_t seed) {
+    prb_tree_t *tree = prb_tree_init(_prb_tree_test_compare, sizeof(uint32_t), 64);
+    TEST_ASSERT(tree)
+
+    version_t *versions = calloc(SNAPSHOTS, sizeof(version_t));
+    TEST_ASSERT(versions)
+
+    bool model[KEYS] = {false};
+    srand(seed);
+
+    for (uint32_t step = 0; step < STEPS; step++) {
+        uint32_t key = rand() % KEYS;
+        uint32_t out = KEYS;
+        version_t *version = &versions[rand() % SNAPSHOTS];
+
+        switch (rand() % 6) {
+            case 0:
+            case 1: {
+                const uint32_t *value = prb_tree_insert(tree, &key);
+                TEST_ASSERT((value != NULL) == !model[key])
+                TEST_ASSERT(!value || *value == key)
+                model[key] = true;
+                break;
+            }
+            case 2:
+            case 3: {
+                TEST_ASSERT(prb_tree_remove(tree, &key, &out) == model[key])
+                TEST_ASSERT(!model[key] || out == key)
+                model[key] = false;
+                break;
+            }
+            case 4: {
+                const uint32_t *found = prb_tree_find(tree, &key);
+                TEST_ASSERT(model[key] ? found && *found == key : !found)
+                break;
+            }
+            case 5: {
+                /*Releasing old snapshot and taking a new one in its place*/
+                if (version->snapshot) {
+                    if (!_prb_tree_test_snapshot(version, key)) {
+                        return false;
+                    }
+                    prb_snapshot_release(version->snapshot);
+                }
+
+                version->snapshot = prb_tree_snapshot(tree);
+                TEST_ASSERT(version->snapshot)
+                for (uint32_t i = 0; i < KEYS; i++) {
+                    version->model[i] = model[i];
+                }
+                break;
+            }
+        }
+
+        if (step % CHECK_EVERY == 0) {
+            walk_t walk = {model, 0, 0, true};
+            prb_tree_foreach(tree, _prb_tree_test_walk, &walk);
+            TEST_ASSERT(walk.ordered && walk.count == _prb_tree_test_count(model))
+            TEST_ASSERT(prb_tree_size(tree) == walk.count)
+
+            if (version->snapshot && !_prb_tree_test_snapshot(version, key)) {
+                return false;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < SNAPSHOTS; i++) {
+        if (versions[i].snapshot) {
+            TEST_ASSERT(_prb_tree_test_snapshot(&versions[i], 0))
+            prb_snapshot_release(versions[i].snapshot);
+        }
+    }
+
+    /*Writer reclaims released versions on its next update*/
+    uint32_t key = KEYS;
+    TEST_ASSERT(prb_tree_insert(tree, &key))
+
+    free(versions);
+    prb_tree_term(tree);
+    return true;
+}
+
+bool prb_tree_test(void) {
+    for (uint32_t seed = 0; seed < 4; seed++) {
+        TEST_ASSERT(_prb_tree_test_model(seed))
+    }
+    return true;
+}
@@ -0,0 +1,120 @@
+#include "test.h"
+
+#include "meal/rb_link.h"
+
+#include <stdlib.h>
+
+#define KEYS 2048
+
+#define STEPS 200000
+
+#define CHECK_EVERY 64
+
+/*Red-black invariants of the shared links, walks both ways and size must agree with the model*/
+static bool _rb_link_test_check(rb_u32_tree_t *tree, const bool *model) {
+    TEST_ASSERT(rb_link_check(tree->root))
+
+    uint32_t count = 0;
+    rb_u32_tree_entry_t *entry = rb_u32_tree_first(tree);
+    for (uint32_t key = 0; key < KEYS; key++) {
+        if (model[key]) {
+            TEST_ASSERT(entry && entry->key == key && entry->value == (void *)(uintptr_t)(key + 1))
+            entry = rb_u32_tree_next(entry);
+            count++;
+        }
+    }
+    TEST_ASSERT(!entry)
+    TEST_ASSERT(rb_u32_tree_size(tree) == count)
+
+    entry = rb_u32_tree_last(tree);
+    for (uint32_t key = KEYS; key > 0; key--) {
+        if (model[key - 1]) {
+            TEST_ASSERT(entry && entry->key == key - 1)
+            entry = rb_u32_tree_prev(entry);
+        }
+    }
+    TEST_ASSERT(!entry)
+    return true;
+}
+
+/*Inlined lookups against a scan of the model*/
+static bool _rb_link_test_find(rb_u32_tree_t *tree, const bool *model, uint32_t key) {
+    uint32_t above = key;
+    while (above < KEYS && !model[above]) {
+        above++;
+    }
+
+    uint32_t below = key + 1;
+    while (below && !model[below - 1]) {
+        below--;
+    }
+
+    const rb_u32_tree_entry_t *found = rb_u32_tree_find(tree, key);
+    const rb_u32_tree_entry_t *min = rb_u32_tree_min(tree, key);
+    const rb_u32_tree_entry_t *max = rb_u32_tree_max(tree, key);
+
+    TEST_ASSERT(model[key] ? found && found->key == key : !found)
+    TEST_ASSERT(above < KEYS ? min && min->key == above : !min)
+    TEST_ASSERT(below ? max && max->key == below - 1 : !max)
+    return true;
+}
+
+static bool _rb_link_test_model(uint32_t seed) {
+    rb_u32_tree_t *tree = rb_u32_tree_init(64);
+    TEST_ASSERT(tree)
+
+    bool model[KEYS] = {false};
+    srand(seed);
+
+    for (uint32_t step = 0; step < STEPS; step++) {
+        const uint32_t key = rand() % KEYS;
+        void *value = (void *)(uintptr_t)(key + 1);
+
+        switch (rand() % 6) {
+            case 0:
+            case 1:
+            case 2: {
+                TEST_ASSERT((rb_u32_tree_insert(tree, key, value) != NULL) == !model[key])
+                model[key] = true;
+                break;
+            }
+            case 3: {
+                void *out = NULL;
+                TEST_ASSERT(rb_u32_tree_remove(tree, key, &out) == model[key])
+                TEST_ASSERT(!model[key] || out == value)
+                model[key] = false;
+                break;
+            }
+            case 4: {
+                /*Erasing from the middle of a walk takes the two children path most often*/
+                rb_u32_tree_entry_t *entry = rb_u32_tree_min(tree, key);
+                if (entry) {
+                    model[entry->key] = false;
+                    rb_u32_tree_remove_entry(tree, entry);
+                }
+                break;
+            }
+            case 5: {
+                if (!_rb_link_test_find(tree, model, key)) {
+                    return false;
+                }
+                break;
+            }
+        }
+
+        if (step % CHECK_EVERY == 0 && !_rb_link_test_check(tree, model)) {
+            return false;
+        }
+    }
+
+    const bool result = _rb_link_test_check(tree, model);
+    rb_u32_tree_term(tree);
+    return result;
+}
+
+bool rb_link_test(void) {
+    for (uint32_t seed = 0; seed < 4; seed++) {
+        TEST_ASSERT(_rb_link_test_model(seed))
+    }
+    return true;
+}
@@ -0,0 +1,196 @@
+#include "test.h"
+
+#include "meal/rb_tree_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define KEYS 4096
+
+#define PATH "rb_tree_image_test.bin"
+
+static int32_t _rb_tree_image_test_compare(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int32_t _rb_tree_image_test_reverse(const void *a, const void *b) {
+    return _rb_tree_image_test_compare(b, a);
+}
+
+/*Sees 2k and 2k + 1 as the same key*/
+static int32_t _rb_tree_image_test_halves(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *)a / 2;
+    const uint32_t y = *(const uint32_t *)b / 2;
+    return (x > y) - (x < y);
+}
+
+static int32_t _rb_tree_image_test_compare16(const void *a, const void *b) {
+    const uint16_t x = *(const uint16_t *)a;
+    const uint16_t y = *(const uint16_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*Every lookup of the mapped image against a scan of the model*/
+static bool _rb_tree_image_test_lookups(rb_tree_image_t *image, const bool *model) {
+    uint32_t count = 0;
+    for (uint32_t key = 0; key < KEYS; key++) {
+        if (model[key]) {
+            const uint32_t *value = rb_tree_image_at(image, count++);
+            TEST_ASSERT(value && *value == key)
+        }
+    }
+    TEST_ASSERT(rb_tree_image_size(image) == count && !rb_tree_image_at(image, count))
+
+    for (uint32_t key = 0; key < KEYS; key++) {
+        uint32_t above = key;
+        while (above < KEYS && !model[above]) {
+            above++;
+        }
+
+        uint32_t below = key + 1;
+        while (below && !model[below - 1]) {
+            below--;
+        }
+
+        const uint32_t *found = rb_tree_image_find(image, &key);
+        const uint32_t *min = rb_tree_image_min(image, &key);
+        const uint32_t *max = rb_tree_image_max(image, &key);
+
+        TEST_ASSERT(model[key] ? found && *found == key : !found)
+        TEST_ASSERT(above < KEYS ? min && *min == above : !min)
+        TEST_ASSERT(below ? max && *max == below - 1 : !max)
+    }
+    return true;
+}
+
+/*Saved tree is searched in place and loads back into an equal tree*/
+static bool _rb_tree_image_test_round_trip(uint32_t count, uint32_t seed) {
+    rb_tree_t *tree = rb_tree_init(_rb_tree_image_test_compare, sizeof(uint32_t), 64);
+    TEST_ASSERT(tree)
+
+    bool model[KEYS] = {false};
+    srand(seed);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t key = rand() % KEYS;
+        rb_tree_insert(tree, &key);
+        model[key] = true;
+    }
+
+    TEST_ASSERT(rb_tree_save_file(tree, PATH))
+
+    rb_tree_image_t *image = rb_tree_load_mapped(PATH, _rb_tree_image_test_compare, sizeof(uint32_t));
+    TEST_ASSERT(image)
+    TEST_ASSERT(rb_tree_image_verify(image))
+    TEST_ASSERT(_rb_tree_image_test_lookups(image, model))
+    rb_tree_image_term(image);
+
+    rb_tree_t *loaded = rb_tree_init_ranked(_rb_tree_image_test_compare, sizeof(uint32_t), 64);
+    TEST_ASSERT(loaded)
+    TEST_ASSERT(rb_tree_load(loaded, PATH))
+    TEST_ASSERT(rb_tree_check(loaded) && rb_tree_size(loaded) == rb_tree_size(tree))
+
+    rb_tree_iter_s iter;
+    const uint32_t *value = rb_tree_begin_iter_tmp(loaded, &iter);
+    for (uint32_t key = 0; key < KEYS; key++) {
+        if (model[key]) {
+            TEST_ASSERT(value && *value == key)
+            value = rb_tree_iter_tmp_next(&iter);
+        }
+    }
+    TEST_ASSERT(!value)
+
+    rb_tree_term(loaded);
+    rb_tree_term(tree);
+    return true;
+}
+
+static bool _rb_tree_image_test_truncate(void) {
+    FILE *file = fopen(PATH, "rb");
+    TEST_ASSERT(file)
+    TEST_ASSERT(!fseek(file, 0, SEEK_END))
+
+    const long size = ftell(file);
+    TEST_ASSERT(size > 1)
+
+    char *buffer = malloc(size);
+    TEST_ASSERT(buffer)
+    rewind(file);
+    TEST_ASSERT(fread(buffer, 1, size, file) == (size_t)size)
+    fclose(file);
+
+    file = fopen(PATH, "wb");
+    TEST_ASSERT(file)
+    TEST_ASSERT(fwrite(buffer, 1, size - 1, file) == (size_t)size - 1)
+    fclose(file);
+    free(buffer);
+    return true;
+}
+
+/*Images that don't match the caller's type or order are refused, in release builds too*/
+static bool _rb_tree_image_test_reject(void) {
+    rb_tree_t *tree = rb_tree_init(_rb_tree_image_test_compare, sizeof(uint32_t), 64);
+    rb_tree_t *target = rb_tree_init(_rb_tree_image_test_compare, sizeof(uint32_t), 64);
+    TEST_ASSERT(tree && target)
+
+    for (uint32_t key = 0; key < KEYS; key++) {
+        TEST_ASSERT(rb_tree_insert(tree, &key))
+    }
+    TEST_ASSERT(rb_tree_save_file(tree, PATH))
+
+    /*File length matches for a type of half the size and twice the count, so typeSize must be checked*/
+    TEST_ASSERT(!rb_tree_load_mapped(PATH, _rb_tree_image_test_compare16, sizeof(uint16_t)))
+    TEST_ASSERT(!rb_tree_load_mapped(PATH, _rb_tree_image_test_compare, sizeof(uint64_t)))
+
+    rb_tree_t *narrow = rb_tree_init(_rb_tree_image_test_compare16, sizeof(uint16_t), 64);
+    TEST_ASSERT(narrow)
+    TEST_ASSERT(!rb_tree_load(narrow, PATH) && !rb_tree_size(narrow))
+    rb_tree_term(narrow);
+
+    /*Neighbours equal under this comparator: mapping trusts the order, verify and load don't*/
+    rb_tree_t *halves = rb_tree_init(_rb_tree_image_test_halves, sizeof(uint32_t), 64);
+    TEST_ASSERT(halves)
+    rb_tree_image_t *image = rb_tree_load_mapped(PATH, _rb_tree_image_test_halves, sizeof(uint32_t));
+    TEST_ASSERT(image && !rb_tree_image_verify(image))
+    rb_tree_image_term(image);
+    TEST_ASSERT(!rb_tree_load(halves, PATH) && !rb_tree_size(halves))
+    rb_tree_term(halves);
+
+    /*Descending file*/
+    rb_tree_t *reverse = rb_tree_init(_rb_tree_image_test_reverse, sizeof(uint32_t), 64);
+    TEST_ASSERT(reverse)
+    for (uint32_t key = 0; key < KEYS; key++) {
+        TEST_ASSERT(rb_tree_insert(reverse, &key))
+    }
+    TEST_ASSERT(rb_tree_save_file(reverse, PATH))
+    rb_tree_term(reverse);
+
+    image = rb_tree_load_mapped(PATH, _rb_tree_image_test_compare, sizeof(uint32_t));
+    TEST_ASSERT(image && !rb_tree_image_verify(image))
+    rb_tree_image_term(image);
+    TEST_ASSERT(!rb_tree_load(target, PATH) && !rb_tree_size(target))
+
+    /*Length no longer matches the header*/
+    TEST_ASSERT(rb_tree_save_file(tree, PATH))
+    TEST_ASSERT(_rb_tree_image_test_truncate())
+    TEST_ASSERT(!rb_tree_load_mapped(PATH, _rb_tree_image_test_compare, sizeof(uint32_t)))
+    TEST_ASSERT(!rb_tree_load(target, PATH) && !rb_tree_size(target))
+
+    TEST_ASSERT(!rb_tree_load_mapped(PATH ".missing", _rb_tree_image_test_compare, sizeof(uint32_t)))
+
+    rb_tree_term(target);
+    rb_tree_term(tree);
+    return true;
+}
+
+bool rb_tree_image_test(void) {
+    const uint32_t counts[] = {0, 1, 100, KEYS * 2};
+    for (uint32_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        TEST_ASSERT(_rb_tree_image_test_round_trip(counts[i], i))
+    }
+
+    const bool result = _rb_tree_image_test_reject();
+    remove(PATH);
+    return result;
+}
@@ -0,0 +1,454 @@
+#include "test.h"
+
+#include "meal/rb_tree.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define KEYS 2048
+
+#define STEPS 200000
+
+#define CHECK_EVERY 64
+
+static int32_t _rb_tree_test_compare(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void _rb_tree_test_count(void *ptr, void *data) {
+    (*(uint32_t *)data)++;
+}
+
+/*Red-black invariants, in-order walk, ranks and size must all agree with the model*/
+static bool _rb_tree_test_check(rb_tree_t *tree, const bool *model, bool ranked) {
+    TEST_ASSERT(rb_tree_check(tree))
+
+    uint32_t count = 0;
+    rb_tree_iter_s iter;
+    const uint32_t *value = rb_tree_begin_iter_tmp(tree, &iter);
+    for (uint32_t key = 0; key < KEYS; key++) {
+        if (!model[key]) {
+            continue;
+        }
+
+        TEST_ASSERT(value && *value == key)
+        if (ranked) {
+            TEST_ASSERT(rb_tree_select(tree, count) == value)
+            TEST_ASSERT(rb_tree_rank(tree, value) == count)
+        }
+
+        count++;
+        value = rb_tree_iter_tmp_next(&iter);
+    }
+
+    TEST_ASSERT(!value)
+    TEST_ASSERT(rb_tree_size(tree) == count)
+
+    /*Pool allocated iterators and their copies walk the same order*/
+    if (count) {
+        iter_t *walk = rb_tree_iter(tree);
+        iter_t *copy = iter_copy(walk);
+        TEST_ASSERT(walk && copy)
+
+        value = rb_tree_begin_iter_tmp(tree, &iter);
+        while (value) {
+            TEST_ASSERT(iter_value(walk) == value && iter_value(copy) == value)
+            iter_next(walk);
+            iter_next(copy);
+            value = rb_tree_iter_tmp_next(&iter);
+        }
+
+        TEST_ASSERT(!iter_value(walk) && !iter_value(copy))
+        iter_term(walk);
+        iter_term(copy);
+    }
+    return true;
+}
+
+/*Random inserts mixed with every removal flavour, checked against a presence array*/
+static bool _rb_tree_test_remove(bool ranked, uint32_t seed) {
+    rb_tree_t *tree = ranked ? rb_tree_init_ranked(_rb_tree_test_compare, sizeof(uint32_t), 64) :
+                      rb_tree_init(_rb_tree_test_compare, sizeof(uint32_t), 64);
+    TEST_ASSERT(tree)
+
+    bool model[KEYS] = {false};
+    srand(seed);
+
+    for (uint32_t step = 0; step < STEPS; step++) {
+        uint32_t key = rand() % KEYS;
+        uint32_t out = KEYS;
+
+        switch (rand() % 8) {
+            case 0:
+            case 1:
+            case 2: {
+                TEST_ASSERT((rb_tree_insert(tree, &key) != NULL) == !model[key])
+                model[key] = true;
+                break;
+            }
+            case 3:
+            case 4: {
+                TEST_ASSERT(rb_tree_remove(tree, &key, &out) == model[key])
+                TEST_ASSERT(!model[key] || out == key)
+                model[key] = false;
+                break;
+            }
+            case 5: {
+                uint32_t expected = key;
+                while (expected < KEYS && !model[expected]) {
+                    expected++;
+                }
+
+                TEST_ASSERT(rb_tree_remove_min(tree, &key, &out) == (expected < KEYS))
+                if (expected < KEYS) {
+                    TEST_ASSERT(out == expected)
+                    model[expected] = false;
+                }
+                break;
+            }
+            case 6: {
+                uint32_t expected = key + 1;
+                while (expected && !model[expected - 1]) {
+                    expected--;
+                }
+
+                TEST_ASSERT(rb_tree_remove_max(tree, &key, &out) == (expected != 0))
+                if (expected) {
+                    TEST_ASSERT(out == expected - 1)
+                    model[expected - 1] = false;
+                }
+                break;
+            }
+            case 7: {
+                if (rand() % 16) {
+                    break;
+                }
+
+                /*All three range calls take the half-open [key, max)*/
+                const uint32_t max = key + rand() % 64;
+                uint32_t expected = 0;
+                for (uint32_t i = key; i < max && i < KEYS; i++) {
+                    expected += model[i];
+                    model[i] = false;
+                }
+
+                uint32_t visited = 0;
+                rb_tree_foreach_range(tree, &key, &max, _rb_tree_test_count, &visited);
+                TEST_ASSERT(visited == expected)
+                TEST_ASSERT(!ranked || rb_tree_count_range(tree, &key, &max) == expected)
+                TEST_ASSERT(rb_tree_remove_range(tree, &key, &max) == expected)
+                break;
+            }
+        }
+
+        if (step % CHECK_EVERY == 0 && !_rb_tree_test_check(tree, model, ranked)) {
+            return false;
+        }
+    }
+
+    const bool result = _rb_tree_test_check(tree, model, ranked);
+    rb_tree_term(tree);
+    return result;
+}
+
+/*Order statistics on a plain tree must refuse in release builds too, there are no counts to read*/
+static bool _rb_tree_test_plain_rank(void) {
+    rb_tree_t *tree = rb_tree_init(_rb_tree_test_compare, sizeof(uint32_t), 64);
+    TEST_ASSERT(tree)
+
+    for (uint32_t key = 0; key < KEYS; key++) {
+        TEST_ASSERT(rb_tree_insert(tree, &key))
+    }
+
+    const uint32_t min = 0;
+    const uint32_t max = KEYS;
+    TEST_ASSERT(!rb_tree_select(tree, 1))
+    TEST_ASSERT(!rb_tree_rank(tree, &max))
+    TEST_ASSERT(!rb_tree_count_range(tree, &min, &max))
+
+    rb_tree_term(tree);
+    return true;
+}
+
+bool rb_tree_remove_test(void) {
+    for (uint32_t seed = 0; seed < 4; seed++) {
+        TEST_ASSERT(_rb_tree_test_remove(false, seed))
+        TEST_ASSERT(_rb_tree_test_remove(true, seed))
+    }
+
+    TEST_ASSERT(_rb_tree_test_plain_rank())
+    return true;
+}
+
+#define SPLIT_STEPS 4000
+
+/*Splits at random keys and puts halves back by join or merge, also merges random sibling contents*/
+static bool _rb_tree_test_split(bool ranked, uint32_t seed) {
+    rb_tree_t *tree = ranked ? rb_tree_init_ranked(_rb_tree_test_compare, sizeof(uint32_t), 64) :
+                      rb_tree_init(_rb_tree_test_compare, sizeof(uint32_t), 64);
+    TEST_ASSERT(tree)
+
+    rb_tree_t *right = rb_tree_init_sibling(tree);
+    rb_tree_t *other = rb_tree_init_sibling(tree);
+    rb_tree_t *stranger = rb_tree_init(_rb_tree_test_compare, sizeof(uint32_t), 64);
+    TEST_ASSERT(right && other && stranger)
+
+    bool model[KEYS] = {false};
+    bool rightModel[KEYS] = {false};
+    bool otherModel[KEYS] = {false};
+    srand(seed);
+
+    for (uint32_t step = 0; step < SPLIT_STEPS; step++) {
+        uint32_t key = rand() % KEYS;
+
+        switch (rand() % 4) {
+            case 0: {
+                for (uint32_t i = 0; i < 32; i++) {
+                    key = rand() % KEYS;
+                    TEST_ASSERT((rb_tree_insert(tree, &key) != NULL) == !model[key])
+                    model[key] = true;
+                }
+                break;
+            }
+            case 1: {
+                TEST_ASSERT(rb_tree_split(tree, &key, right))
+                for (uint32_t i = key; i < KEYS; i++) {
+                    rightModel[i] = model[i];
+                    model[i] = false;
+                }
+
+                TEST_ASSERT(_rb_tree_test_check(tree, model, ranked))
+                TEST_ASSERT(_rb_tree_test_check(right, rightModel, ranked))
+
+                /*Halves don't overlap, so join and merge both put everything back*/
+                if (rand() % 2) {
+                    TEST_ASSERT(rb_tree_join(tree, right))
+                } else {
+                    TEST_ASSERT(rb_tree_merge(tree, right) == 0)
+                }
+
+                for (uint32_t i = key; i < KEYS; i++) {
+                    model[i] = rightModel[i];
+                    rightModel[i] = false;
+                }
+                break;
+            }
+            case 2: {
+                uint32_t duplicates = 0;
+                for (uint32_t i = 0; i < 64; i++) {
+                    key = rand() % KEYS;
+                    if (!otherModel[key]) {
+                        TEST_ASSERT(rb_tree_insert(other, &key))
+                        otherModel[key] = true;
+                        duplicates += model[key];
+                    }
+                }
+
+                TEST_ASSERT(rb_tree_merge(tree, other) == duplicates)
+                for (uint32_t i = 0; i < KEYS; i++) {
+                    model[i] = model[i] || otherModel[i];
+                    otherModel[i] = false;
+                }
+                TEST_ASSERT(!rb_tree_size(other))
+                break;
+            }
+            case 3: {
+                /*Refusals must hold in release builds, they guard against corrupting both trees*/
+                if (rand() % 64) {
+                    break;
+                }
+
+                TEST_ASSERT(!rb_tree_split(tree, &key, stranger))
+                TEST_ASSERT(!rb_tree_join(tree, stranger))
+                TEST_ASSERT(!rb_tree_merge(tree, stranger))
+
+                uint32_t low = 0;
+                while (low < KEYS && !model[low]) {
+                    low++;
+                }
+
+                if (low < KEYS) {
+                    TEST_ASSERT(rb_tree_insert(right, &low))
+                    TEST_ASSERT(!rb_tree_join(tree, right))
+                    TEST_ASSERT(!rb_tree_split(tree, &key, right))
+                    TEST_ASSERT(rb_tree_merge(tree, right) == 1)
+                }
+                break;
+            }
+        }
+
+        if (step % 8 == 0 && (!_rb_tree_test_check(tree, model, ranked) ||
+                              !_rb_tree_test_check(right, rightModel, ranked) ||
+                              !_rb_tree_test_check(other, otherModel, ranked))) {
+            return false;
+        }
+    }
+
+    rb_tree_term(stranger);
+    rb_tree_term(other);
+    rb_tree_term(right);
+    rb_tree_term(tree);
+    return true;
+}
+
+bool rb_tree_split_test(void) {
+    for (uint32_t seed = 0; seed < 2; seed++) {
+        TEST_ASSERT(_rb_tree_test_split(false, seed))
+        TEST_ASSERT(_rb_tree_test_split(true, seed))
+    }
+    return true;
+}
+
+#define COMPACT_KEYS 1024
+
+/*Compact must refuse while a sibling shares the pool in release builds too, then keep every element*/
+static bool _rb_tree_test_compact(bool ranked, uint32_t seed) {
+    rb_tree_t *tree = ranked ? rb_tree_init_ranked(_rb_tree_test_compare, sizeof(uint32_t), 64) :
+                      rb_tree_init(_rb_tree_test_compare, sizeof(uint32_t), 64);
+    TEST_ASSERT(tree)
+
+    rb_tree_t *sibling = rb_tree_init_sibling(tree);
+    TEST_ASSERT(sibling)
+
+    bool model[KEYS] = {false};
+    bool siblingModel[KEYS] = {false};
+    srand(seed);
+
+    /*Interleaved inserts and removals scatter both trees over the shared blocks*/
+    for (uint32_t step = 0; step < COMPACT_KEYS * 4; step++) {
+        uint32_t key = rand() % KEYS;
+        const bool toSibling = rand() % 2;
+        rb_tree_t *target = toSibling ? sibling : tree;
+        bool *targetModel = toSibling ? siblingModel : model;
+
+        if (rand() % 3) {
+            TEST_ASSERT((rb_tree_insert(target, &key) != NULL) == !targetModel[key])
+            targetModel[key] = true;
+        } else {
+            TEST_ASSERT(rb_tree_remove(target, &key, NULL) == targetModel[key])
+            targetModel[key] = false;
+        }
+    }
+
+    TEST_ASSERT(!rb_tree_compact(tree))
+    TEST_ASSERT(!rb_tree_compact(sibling))
+    TEST_ASSERT(_rb_tree_test_check(tree, model, ranked))
+    TEST_ASSERT(_rb_tree_test_check(sibling, siblingModel, ranked))
+
+    rb_tree_term(sibling);
+    TEST_ASSERT(rb_tree_compact(tree))
+    TEST_ASSERT(_rb_tree_test_check(tree, model, ranked))
+
+    /*Compacted tree keeps working on its new pool*/
+    for (uint32_t key = 0; key < KEYS; key += 3) {
+        TEST_ASSERT((rb_tree_insert(tree, &key) != NULL) == !model[key])
+        model[key] = true;
+    }
+    TEST_ASSERT(_rb_tree_test_check(tree, model, ranked))
+
+    rb_tree_term(tree);
+    return true;
+}
+
+bool rb_tree_compact_test(void) {
+    for (uint32_t seed = 0; seed < 4; seed++) {
+        TEST_ASSERT(_rb_tree_test_compact(false, seed))
+        TEST_ASSERT(_rb_tree_test_compact(true, seed))
+    }
+    return true;
+}
+
+#define PARALLEL_INITIAL 100
+
+typedef struct fold_t {
+    uint64_t sum;
+    uint32_t count;
+    uint32_t first;
+    uint32_t last;
+    bool ordered;
+} fold_t;
+
+static void _rb_tree_test_sum(void *ptr, void *data) {
+    ((fold_t *)data)->sum += *(uint32_t *)ptr;
+    ((fold_t *)data)->count++;
+}
+
+static void _rb_tree_test_atomic_sum(void *ptr, void *data) {
+    atomic_fetch_add_explicit((atomic_uint_fast64_t *)data, *(uint32_t *)ptr, memory_order_relaxed);
+}
+
+/*Order is tracked too, chunks must be combined in key order*/
+static void _rb_tree_test_reduce(void *acc, const void *ptr, void *data) {
+    fold_t *fold = acc;
+    const uint32_t value = *(const uint32_t *)ptr;
+    if (fold->count) {
+        fold->ordered = fold->ordered && fold->last < value;
+    } else {
+        fold->first = value;
+    }
+
+    fold->sum += value;
+    fold->last = value;
+    fold->count++;
+}
+
+static void _rb_tree_test_combine(void *acc, const void *other, void *data) {
+    fold_t *fold = acc;
+    const fold_t *part = other;
+    if (!part->count) {
+        return;
+    }
+
+    if (fold->count) {
+        fold->ordered = fold->ordered && part->ordered && fold->last < part->first;
+    } else {
+        fold->first = part->first;
+        fold->ordered = part->ordered;
+    }
+
+    fold->sum += part->sum;
+    fold->last = part->last;
+    fold->count += part->count;
+}
+
+/*Initial acc must be counted once whatever the number of chunks*/
+static bool _rb_tree_test_parallel(bool ranked, uint32_t size, uint32_t seed) {
+    rb_tree_t *tree = ranked ? rb_tree_init_ranked(_rb_tree_test_compare, sizeof(uint32_t), 64) :
+                      rb_tree_init(_rb_tree_test_compare, sizeof(uint32_t), 64);
+    TEST_ASSERT(tree)
+
+    srand(seed);
+    while (rb_tree_size(tree) < size) {
+        uint32_t key = rand();
+        rb_tree_insert(tree, &key);
+    }
+
+    fold_t expected = {PARALLEL_INITIAL, 0, 0, 0, true};
+    rb_tree_foreach(tree, _rb_tree_test_sum, &expected);
+
+    const fold_t identity = {0, 0, 0, 0, true};
+    for (uint32_t threads = 1; threads <= 8; threads *= 2) {
+        fold_t fold = {PARALLEL_INITIAL, 0, 0, 0, true};
+        TEST_ASSERT(rb_tree_parallel_reduce(tree, threads, _rb_tree_test_reduce, _rb_tree_test_combine, &identity,
+                                            &fold, sizeof(fold_t), NULL))
+        TEST_ASSERT(fold.sum == expected.sum && fold.count == expected.count && fold.ordered)
+
+        atomic_uint_fast64_t sum = PARALLEL_INITIAL;
+        rb_tree_parallel_foreach(tree, threads, _rb_tree_test_atomic_sum, &sum);
+        TEST_ASSERT(atomic_load(&sum) == expected.sum)
+    }
+
+    rb_tree_term(tree);
+    return true;
+}
+
+bool rb_tree_parallel_test(void) {
+    const uint32_t sizes[] = {0, 1, 3, 31, 1000, 50000};
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        TEST_ASSERT(_rb_tree_test_parallel(false, sizes[i], i))
+        TEST_ASSERT(_rb_tree_test_parallel(true, sizes[i], i))
+    }
+    return true;
+}
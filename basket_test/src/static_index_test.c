@@ -0,0 +1,117 @@
+#include "test.h"
+
+#include "meal/static_index.h"
+
+#include <stdlib.h>
+
+#define KEYS 4096
+
+typedef struct walk_t {
+    const bool *model;
+    uint32_t next;
+    uint32_t count;
+    bool ordered;
+} walk_t;
+
+static int32_t _static_index_test_compare(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*Each visited key must be the next present one of the model*/
+static void _static_index_test_walk(const void *ptr, void *data) {
+    walk_t *walk = data;
+    while (walk->next < KEYS && !walk->model[walk->next]) {
+        walk->next++;
+    }
+
+    walk->ordered = walk->ordered && walk->next == *(const uint32_t *)ptr;
+    walk->next++;
+    walk->count++;
+}
+
+/*In-order iteration starting at key, or at the beginning when key is KEYS*/
+static bool _static_index_test_iter(static_index_t *index, const bool *model, uint32_t key, uint32_t count) {
+    static_index_iter_s iter;
+    const uint32_t *value = key < KEYS ? static_index_min_iter_tmp(index, &key, &iter) :
+                            static_index_begin_iter_tmp(index, &iter);
+
+    walk_t walk = {model, key < KEYS ? key : 0, 0, true};
+    while (value) {
+        _static_index_test_walk(value, &walk);
+        value = static_index_iter_tmp_next(&iter);
+    }
+
+    uint32_t expected = 0;
+    for (uint32_t i = key < KEYS ? key : 0; i < KEYS; i++) {
+        expected += model[i];
+    }
+
+    TEST_ASSERT(walk.ordered && walk.count == expected && expected <= count)
+    return true;
+}
+
+/*Eytzinger layout must answer every lookup the way the sorted model does*/
+static bool _static_index_test_model(uint32_t count, uint32_t seed) {
+    rb_tree_t *tree = rb_tree_init(_static_index_test_compare, sizeof(uint32_t), 64);
+    TEST_ASSERT(tree)
+
+    bool model[KEYS] = {false};
+    srand(seed);
+    while (rb_tree_size(tree) < count) {
+        uint32_t key = rand() % KEYS;
+        rb_tree_insert(tree, &key);
+        model[key] = true;
+    }
+
+    static_index_t *index = static_index_init(tree);
+    TEST_ASSERT(index)
+    TEST_ASSERT(static_index_size(index) == count)
+
+    /*Index is a snapshot, later tree updates don't reach it*/
+    uint32_t extra = KEYS;
+    TEST_ASSERT(rb_tree_insert(tree, &extra))
+    rb_tree_term(tree);
+
+    walk_t walk = {model, 0, 0, true};
+    static_index_foreach(index, _static_index_test_walk, &walk);
+    TEST_ASSERT(walk.ordered && walk.count == count)
+    TEST_ASSERT(_static_index_test_iter(index, model, KEYS, count))
+
+    for (uint32_t key = 0; key < KEYS; key++) {
+        uint32_t above = key;
+        while (above < KEYS && !model[above]) {
+            above++;
+        }
+
+        uint32_t below = key + 1;
+        while (below && !model[below - 1]) {
+            below--;
+        }
+
+        const uint32_t *found = static_index_find(index, &key);
+        const uint32_t *min = static_index_min(index, &key);
+        const uint32_t *max = static_index_max(index, &key);
+
+        TEST_ASSERT(model[key] ? found && *found == key : !found)
+        TEST_ASSERT(above < KEYS ? min && *min == above : !min)
+        TEST_ASSERT(below ? max && *max == below - 1 : !max)
+
+        if (key % 61 == 0 && !_static_index_test_iter(index, model, key, count)) {
+            return false;
+        }
+    }
+
+    static_index_term(index);
+    return true;
+}
+
+bool static_index_test(void) {
+    /*Complete and incomplete last levels of the implicit tree*/
+    const uint32_t counts[] = {0, 1, 2, 3, 7, 8, 9, 100, 1023, 1024, 3000};
+    for (uint32_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        TEST_ASSERT(_static_index_test_model(counts[i], i))
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef MEAL_BASKET_TEST_H
+#define MEAL_BASKET_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/*Unlike assert it stays in release builds, stress tests are most useful there*/
+#define TEST_ASSERT(expression)\
+if (!(expression)) {\
+    fprintf(stderr, "%s:%d: '%s' failed\n", __FILE__, __LINE__, #expression);\
+    return false;\
+}
+
+bool hash_stack_test(void);
+
+bool deque_test(void);
+
+bool ws_deque_test(void);
+
+bool rb_tree_remove_test(void);
+
+bool rb_tree_split_test(void);
+
+bool rb_tree_compact_test(void);
+
+bool rb_tree_parallel_test(void);
+
+bool rb_tree_image_test(void);
+
+bool static_index_test(void);
+
+bool rb_link_test(void);
+
+bool prb_tree_test(void);
+
+bool bp_tree_test(void);
+
+bool crb_tree_test(void);
+
+#endif //MEAL_BASKET_TEST_H
@@ -0,0 +1,89 @@
+#include "test.h"
+
+#include "meal/ws_deque.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define TASKS 1000000
+
+#define THIEVES 4
+
+typedef struct stress_t {
+    ws_deque_t *deque;
+    atomic_uchar *taken;
+    uint32_t *tasks;
+    atomic_bool done;
+    atomic_bool twice;
+} stress_t;
+
+static void _ws_deque_test_take(stress_t *stress, uint32_t *task) {
+    if (atomic_fetch_add_explicit(&stress->taken[task - stress->tasks], 1, memory_order_relaxed)) {
+        atomic_store_explicit(&stress->twice, true, memory_order_relaxed);
+    }
+}
+
+static void *_ws_deque_test_thief(void *data) {
+    stress_t *stress = data;
+    while (!atomic_load_explicit(&stress->done, memory_order_acquire) || ws_deque_size(stress->deque)) {
+        uint32_t *task = ws_deque_steal(stress->deque);
+        if (task) {
+            _ws_deque_test_take(stress, task);
+        }
+    }
+    return NULL;
+}
+
+/*Owner pushes and pops in random bursts while thieves steal, every task must be taken exactly once*/
+bool ws_deque_test(void) {
+    stress_t stress;
+    stress.deque = ws_deque_init(8);
+    stress.taken = calloc(TASKS, sizeof(atomic_uchar));
+    stress.tasks = malloc(TASKS * sizeof(uint32_t));
+    atomic_init(&stress.done, false);
+    atomic_init(&stress.twice, false);
+
+    TEST_ASSERT(stress.deque && stress.taken && stress.tasks)
+
+    pthread_t thieves[THIEVES];
+    for (uint32_t i = 0; i < THIEVES; i++) {
+        TEST_ASSERT(!pthread_create(&thieves[i], NULL, _ws_deque_test_thief, &stress))
+    }
+
+    srand(1);
+    uint32_t next = 0;
+    while (next < TASKS) {
+        for (uint32_t burst = rand() % 200; burst && next < TASKS; burst--, next++) {
+            TEST_ASSERT(ws_deque_push(stress.deque, &stress.tasks[next]))
+        }
+
+        for (uint32_t burst = rand() % 150; burst; burst--) {
+            uint32_t *task = ws_deque_pop(stress.deque);
+            if (!task) {
+                break;
+            }
+            _ws_deque_test_take(&stress, task);
+        }
+    }
+
+    uint32_t *task;
+    while ((task = ws_deque_pop(stress.deque))) {
+        _ws_deque_test_take(&stress, task);
+    }
+
+    atomic_store_explicit(&stress.done, true, memory_order_release);
+    for (uint32_t i = 0; i < THIEVES; i++) {
+        pthread_join(thieves[i], NULL);
+    }
+
+    TEST_ASSERT(!atomic_load(&stress.twice))
+    for (uint32_t i = 0; i < TASKS; i++) {
+        TEST_ASSERT(atomic_load_explicit(&stress.taken[i], memory_order_relaxed) == 1)
+    }
+
+    ws_deque_term(stress.deque);
+    free(stress.taken);
+    free(stress.tasks);
+    return true;
+}
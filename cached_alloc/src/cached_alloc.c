@@ -251,25 +251,20 @@ do {\
     }\
 \
     block_t blockTmp = {ptr};\
-    iter_t *blockIter = rb_tree_find_iter(chunk->blockTree, &blockTmp);\
-    ASSERT_ERROR(blockIter, TAG, "Can't find ptr in alloc") {\
-        iter_term(blockIter);\
+    rb_tree_iter_s blockIter;\
+    block_t *current = rb_tree_iter_tmp(chunk->blockTree, &blockTmp, &blockIter);\
+    ASSERT_ERROR(current, TAG, "Can't find ptr in alloc") {\
         return NULL;\
     }\
 \
-    block_t *current = iter_value(blockIter);\
     if (_size == current->size) {\
         return ptr;\
     }\
 \
     block_t *next = NULL;\
     if (!current->isLast) {\
-        iter_t *blockIterCopy = iter_copy(blockIter);\
-\
-        iter_next(blockIterCopy);\
-        next = iter_value(blockIterCopy);\
-\
-        iter_term(blockIterCopy);\
+        rb_tree_iter_s blockIterCopy = blockIter;\
+        next = rb_tree_iter_tmp_next(&blockIterCopy);\
     }\
 \
     if (_size < current->size) {\
@@ -290,8 +285,6 @@ do {\
 \
             current->size -= diff;\
         }\
-        iter_term(blockIter);\
-\
         return ptr;\
     } else if (next && !next->inUse && current->size + next->size >= _size) {\
         /*Target size bigger*/\
@@ -316,8 +309,6 @@ do {\
 \
             current->size = _size;\
         }\
-        iter_term(blockIter);\
-\
         return ptr;\
     } else {\
         /*Can not merge with next*/\
@@ -325,10 +316,8 @@ do {\
         /*After that allocate new block and copy data*/\
         block_t *prev = NULL;\
         if (chunk->chunk != current->address) {\
-            iter_prev(blockIter);\
-            prev = iter_value(blockIter);\
+            prev = rb_tree_iter_tmp_prev(&blockIter);\
         }\
-        iter_term(blockIter);\
 \
         FREE_BLOCK(_alloc->emptyTree, chunk, prev, current, next);\
 \
@@ -350,38 +339,29 @@ do {\
     }\
 \
     block_t blockTmp = {ptr};\
-    iter_t *blockIter = rb_tree_find_iter(chunk->blockTree, &blockTmp);\
-    ASSERT_ERROR(blockIter, TAG, "Can't find ptr in alloc") {\
-        iter_term(blockIter);\
+    rb_tree_iter_s blockIter;\
+    block_t *current = rb_tree_iter_tmp(chunk->blockTree, &blockTmp, &blockIter);\
+    ASSERT_ERROR(current, TAG, "Can't find ptr in alloc") {\
         return _returnValue;\
     }\
 \
-    block_t *current = iter_value(blockIter);\
     block_t *next = NULL;\
     block_t *prev = NULL;\
 \
     if (!current->isLast) {\
         if (chunk->chunk != current->address) {\
-            iter_t *blockIterCopy = iter_copy(blockIter);\
-\
-            iter_next(blockIterCopy);\
-            next = iter_value(blockIterCopy);\
-\
-            iter_term(blockIterCopy);\
+            rb_tree_iter_s blockIterCopy = blockIter;\
+            next = rb_tree_iter_tmp_next(&blockIterCopy);\
 \
-            iter_prev(blockIter);\
-            prev = iter_value(blockIter);\
+            prev = rb_tree_iter_tmp_prev(&blockIter);\
         } else {\
-            iter_next(blockIter);\
-            next = iter_value(blockIter);\
+            next = rb_tree_iter_tmp_next(&blockIter);\
         }\
     } else {\
         if (chunk->chunk != current->address) {\
-            iter_prev(blockIter);\
-            prev = iter_value(blockIter);\
+            prev = rb_tree_iter_tmp_prev(&blockIter);\
         }\
     }\
-    iter_term(blockIter);\
 \
     FREE_BLOCK(_alloc->emptyTree, chunk, prev, current, next);\
     return _returnValue;\
@@ -11,4 +11,8 @@ typedef void (*action_f)(void *ptr, void *data);
 
 typedef void (*const_action_f)(const void *ptr, void *data);
 
+typedef void (*reduce_f)(void *acc, const void *ptr, void *data);
+
+typedef void (*combine_f)(void *acc, const void *other, void *data);
+
 #endif //MEAL_DEF_H
\ No newline at end of file
@@ -20,4 +20,48 @@ bool list_pool_has(list_pool_t *pool, void *ptr);
 
 void list_pool_free(list_pool_t *pool, void *ptr);
 
+void list_pool_reset(list_pool_t *pool, bool keepBlocks);
+
+const alloc_t *list_pool_as_alloc(list_pool_t *pool);
+
+/*Type-safe wrappers only: allocation stays in the out-of-line list_pool code with runtime sizes*/
+#define LIST_POOL_DECLARE(name, T)\
+typedef struct name##_t name##_t;\
+\
+static inline name##_t *name##_init_via(const alloc_t *alloc, uint32_t bufferSize) {\
+    return (name##_t *)list_pool_init_via(alloc, sizeof(T), bufferSize);\
+}\
+\
+static inline name##_t *name##_init(uint32_t bufferSize) {\
+    return (name##_t *)list_pool_init_via(NULL, sizeof(T), bufferSize);\
+}\
+\
+static inline void name##_term(name##_t *pool) {\
+    list_pool_term((list_pool_t *)pool);\
+}\
+\
+static inline T *name##_get(name##_t *pool) {\
+    return (T *)list_pool_get((list_pool_t *)pool);\
+}\
+\
+static inline T *name##_new(name##_t *pool, T value) {\
+    T *dst = (T *)list_pool_get((list_pool_t *)pool);\
+    if (dst) {\
+        *dst = value;\
+    }\
+    return dst;\
+}\
+\
+static inline bool name##_has(name##_t *pool, T *ptr) {\
+    return list_pool_has((list_pool_t *)pool, ptr);\
+}\
+\
+static inline void name##_free(name##_t *pool, T *ptr) {\
+    list_pool_free((list_pool_t *)pool, ptr);\
+}\
+\
+static inline void name##_reset(name##_t *pool, bool keepBlocks) {\
+    list_pool_reset((list_pool_t *)pool, keepBlocks);\
+}
+
 #endif // MEAL_LIST_POOL_H
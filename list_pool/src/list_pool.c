@@ -2,6 +2,7 @@
 
 #include "meal/platform.h"
 #include "meal/assert.h"
+#include "meal/memory.h"
 #include "meal/def.h"
 
 
@@ -22,9 +23,11 @@ typedef struct node_t {
 
 typedef struct list_pool_t {
     const alloc_t *alloc;
+    alloc_t *asAlloc;
     uint32_t typeSize;
     uint32_t bufferSize;
     block_t *header;
+    block_t *spare;
     node_t *freeTail;
 } list_pool_t;
 
@@ -45,26 +48,37 @@ list_pool_t *list_pool_init_via(const alloc_t *alloc, uint32_t typeSize, uint32_
     }
 
     pool->alloc = alloc;
+    pool->asAlloc = NULL;
     pool->typeSize = (typeSize + (WSB - 1)) & ~(WSB - 1);
     pool->bufferSize = bufferSize;
     pool->header = NULL;
+    pool->spare = NULL;
     pool->freeTail = NULL;
 
     return pool;
 }
 
-void list_pool_term(list_pool_t *pool) {
-    ASSERT_ERROR(pool, TAG, "NULL pool") {
-        return;
-    }
-
-    block_t *header = pool->header;
+static void _list_pool_free_blocks(list_pool_t *pool, block_t *header) {
     while (header) {
         block_t *tmp = header;
         header = header->next;
         alloc_free(pool->alloc, tmp->data);
         alloc_free(pool->alloc, tmp);
     }
+}
+
+void list_pool_term(list_pool_t *pool) {
+    ASSERT_ERROR(pool, TAG, "NULL pool") {
+        return;
+    }
+
+    _list_pool_free_blocks(pool, pool->header);
+    _list_pool_free_blocks(pool, pool->spare);
+
+    if (pool->asAlloc) {
+        alloc_term(pool->asAlloc);
+    }
+
     alloc_free(pool->alloc, pool);
 }
 
@@ -74,24 +88,30 @@ void *list_pool_get(list_pool_t *pool) {
     }
 
     if (!pool->freeTail) {
-        block_t *header = alloc_malloc(pool->alloc, sizeof(block_t));
+        const uint32_t nodeSize = sizeof(node_t) + pool->typeSize;
+        block_t *header = pool->spare;
 
-        ASSERT_ERROR(header, TAG, "Can't allocate memory for pool data") {
-            return NULL;
-        }
+        if (header) {
+            pool->spare = header->next;
+        } else {
+            header = alloc_malloc(pool->alloc, sizeof(block_t));
 
-        const uint32_t nodeSize = sizeof(node_t) + pool->typeSize;
-        void *data = alloc_malloc(pool->alloc, nodeSize * pool->bufferSize);
+            ASSERT_ERROR(header, TAG, "Can't allocate memory for pool data") {
+                return NULL;
+            }
 
-        ASSERT_ERROR(data, TAG, "Can't allocate memory for pool data header") {
-            alloc_free(pool->alloc, header);
-            return NULL;
+            header->data = alloc_malloc(pool->alloc, nodeSize * pool->bufferSize);
+
+            ASSERT_ERROR(header->data, TAG, "Can't allocate memory for pool data header") {
+                alloc_free(pool->alloc, header);
+                return NULL;
+            }
         }
 
         header->next = pool->header;
         pool->header = header;
 
-        header->data = data;
+        void *data = header->data;
         pool->freeTail = data;
 
         for (uint32_t i = pool->bufferSize - 1; i > 0; i--) {
@@ -125,6 +145,7 @@ bool list_pool_has(list_pool_t *pool, void *ptr) {
         if (block->data <= ptr && block->data + blockSize > ptr) {
             return true;
         }
+        block = block->next;
     }
 
     return false;
@@ -147,6 +168,7 @@ void list_pool_free(list_pool_t *pool, void *ptr) {
         if (block->data <= ptr && block->data + blockSize > ptr) {
             goto check_end;
         }
+        block = block->next;
     }
     ASSERT_ERROR(false, TAG, "Ptr does not belong to pool") {};
     return;
@@ -159,3 +181,157 @@ void list_pool_free(list_pool_t *pool, void *ptr) {
     node->next = pool->freeTail;
     pool->freeTail = node;
 }
+
+/*Kept blocks are threaded again only when list_pool_get reaches them, so reset never touches nodes*/
+void list_pool_reset(list_pool_t *pool, bool keepBlocks) {
+    ASSERT_ERROR(pool, TAG, "NULL pool") {
+        return;
+    }
+
+    if (keepBlocks) {
+        block_t *header = pool->header;
+        while (header && header->next) {
+            header = header->next;
+        }
+
+        if (header) {
+            header->next = pool->spare;
+            pool->spare = pool->header;
+        }
+    } else {
+        _list_pool_free_blocks(pool, pool->header);
+        _list_pool_free_blocks(pool, pool->spare);
+        pool->spare = NULL;
+    }
+
+    pool->header = NULL;
+    pool->freeTail = NULL;
+}
+
+static void *_list_pool_malloc(uint32_t size, void *data);
+
+static void *_list_pool_realloc(void *ptr, uint32_t size, void *data);
+
+static void _list_pool_free(void *ptr, void *data);
+
+static const alloc_funcs_t alloc_funcs = {
+        _list_pool_malloc,
+        _list_pool_realloc,
+        _list_pool_free
+};
+
+const alloc_t *list_pool_as_alloc(list_pool_t *pool) {
+    ASSERT_ERROR(pool, TAG, "NULL pool") {
+        return NULL;
+    }
+
+    if (!pool->asAlloc) {
+        pool->asAlloc = alloc_init_via(pool->alloc, &alloc_funcs, pool);
+
+        ASSERT_ERROR(pool->asAlloc, TAG, "Can't allocate memory for alloc wrap") {
+            return NULL;
+        }
+    }
+
+    return pool->asAlloc;
+}
+
+/*Every pointer given out through alloc wrap has a word in front of it:*/
+/*slots of the pool keep the pool itself there, parent allocations keep NULL*/
+#define OWNER(ptr) (((node_t *)ptr - 1)->next)
+
+#define IS_SLOT(pool, ptr) (OWNER(ptr) == (node_t *)pool)
+
+static void *_list_pool_parent_malloc(list_pool_t *pool, uint32_t size) {
+    node_t *node = alloc_malloc(pool->alloc, sizeof(node_t) + size);
+
+    ASSERT_ERROR(node, TAG, "Can't allocate memory in parent alloc: size = %d", size) {
+        return NULL;
+    }
+
+    node->next = NULL;
+    return &node->value;
+}
+
+static void *_list_pool_malloc(uint32_t size, void *data) {
+    list_pool_t *pool = data;
+
+    if (size > pool->typeSize) {
+        return _list_pool_parent_malloc(pool, size);
+    }
+
+    void *ptr = list_pool_get(pool);
+
+    if (ptr) {
+        OWNER(ptr) = (node_t *)pool;
+    }
+
+    return ptr;
+}
+
+static void _list_pool_free(void *ptr, void *data) {
+    list_pool_t *pool = data;
+
+    ASSERT_ERROR(ptr, TAG, "NULL ptr") {
+        return;
+    }
+
+    if (IS_SLOT(pool, ptr)) {
+        list_pool_free(pool, ptr);
+    } else {
+        alloc_free(pool->alloc, (node_t *)ptr - 1);
+    }
+}
+
+static void *_list_pool_realloc(void *ptr, uint32_t size, void *data) {
+    list_pool_t *pool = data;
+
+    if (!ptr) {
+        ASSERT_ERROR(size, TAG, "NULL ptr and zero size") {
+            return NULL;
+        }
+
+        return _list_pool_malloc(size, pool);
+    }
+
+    if (!size) {
+        _list_pool_free(ptr, pool);
+        return NULL;
+    }
+
+    if (IS_SLOT(pool, ptr)) {
+        if (size <= pool->typeSize) {
+            return ptr;
+        }
+
+        /*Slot is too small, moving to parent*/
+        void *newPtr = _list_pool_parent_malloc(pool, size);
+
+        if (newPtr) {
+            mem_copy(newPtr, ptr, pool->typeSize);
+            list_pool_free(pool, ptr);
+        }
+
+        return newPtr;
+    }
+
+    if (size <= pool->typeSize) {
+        /*Fits in slot now, moving back to pool*/
+        void *newPtr = _list_pool_malloc(size, pool);
+
+        if (newPtr) {
+            mem_copy(newPtr, ptr, size);
+            alloc_free(pool->alloc, (node_t *)ptr - 1);
+        }
+
+        return newPtr;
+    }
+
+    node_t *node = alloc_realloc(pool->alloc, (node_t *)ptr - 1, sizeof(node_t) + size);
+
+    ASSERT_ERROR(node, TAG, "Can't reallocate memory in parent alloc: size = %d", size) {
+        return NULL;
+    }
+
+    return &node->value;
+}
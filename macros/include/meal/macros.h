@@ -26,4 +26,10 @@
 
 #define FTERNP(expression, statement1, value2) FTERN(expression, (WST)(statement1), (WST)(value2))
 
+#if defined(__GNUC__)
+#define PREFETCH(ptr) __builtin_prefetch(ptr)
+#else
+#define PREFETCH(ptr) ((void)(ptr))
+#endif
+
 #endif //MEAL_MACROS_H
\ No newline at end of file